@@ -0,0 +1,114 @@
+// radix_key_traits 的示例: 以 std::u16string 和 std::vector<uint8_t> (包含 0 和大于 127 的字节) 为 key 的 RadixTree,
+// 随机修改之后的遍历顺序、查找、前缀匹配和最长匹配与 std::map 对照
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+std::u16string random_u16(std::mt19937& rng) {
+    // 包含代理对的码元和 0
+    static const char16_t alphabet[] = {u'a', u'中', u'文', u'\xd83d', u'\xde00', u'\0'};
+    std::u16string key;
+    int len = rng() % 6;
+    for (int i = 0; i < len; i++) {
+        key += alphabet[rng() % 6];
+    }
+    return key;
+}
+
+std::vector<uint8_t> random_bytes(std::mt19937& rng) {
+    static const uint8_t alphabet[] = {0x00, 0x01, 0x7f, 0x80, 0xff};
+    std::vector<uint8_t> key;
+    int len = rng() % 6;
+    for (int i = 0; i < len; i++) {
+        key.push_back(alphabet[rng() % 5]);
+    }
+    return key;
+}
+
+template <typename K>
+bool starts_with(const K& key, const K& prefix) {
+    return key.size() >= prefix.size() && std::equal(prefix.begin(), prefix.end(), key.begin());
+}
+
+template <typename K, typename Generate>
+bool run(const char* name, Generate generate) {
+    std::mt19937 rng(40);
+    RadixTree<K, int> tree;
+    std::map<K, int> expected;
+
+    for (int i = 0; i < 20000; i++) {
+        K key = generate(rng);
+        if (rng() % 3 != 0) {
+            tree[key] = i;
+            expected[key] = i;
+        } else {
+            tree.erase(key);
+            expected.erase(key);
+        }
+    }
+
+    // 遍历顺序与 std::map 相同 (按元素的 operator< 比较)
+    bool ok = tree.size() == expected.size();
+    typename std::map<K, int>::iterator it = expected.begin();
+    for (typename RadixTree<K, int>::iterator found = tree.begin(); ok && found != tree.end(); ++found, ++it) {
+        ok = found->first == it->first && found->second == it->second;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < 5000; i++) {
+        K key = generate(rng);
+
+        typename RadixTree<K, int>::iterator found = tree.find(key);
+        typename std::map<K, int>::iterator want = expected.find(key);
+        if ((found == tree.end()) != (want == expected.end()) || (want != expected.end() && found->second != want->second))
+            mismatches++;
+
+        // prefix_match: 以 key 为前缀的所有元素
+        std::vector<typename RadixTree<K, int>::iterator> vec;
+        tree.prefix_match(key, vec);
+        size_t count = 0;
+        for (want = expected.lower_bound(key); want != expected.end() && starts_with(want->first, key); ++want) {
+            count++;
+        }
+        if (vec.size() != count)
+            mismatches++;
+        for (size_t j = 0; j < vec.size(); j++) {
+            if (!starts_with(vec[j]->first, key) || expected[vec[j]->first] != vec[j]->second)
+                mismatches++;
+        }
+
+        // longest_match: key 的最长的、本身存在的前缀
+        found = tree.longest_match(key);
+        K longest;
+        bool exists = false;
+        for (size_t len = 0; len <= key.size(); len++) {
+            K prefix(key.begin(), key.begin() + len);
+            if (expected.count(prefix) != 0) {
+                longest = prefix;
+                exists = true;
+            }
+        }
+        if ((found != tree.end()) != exists || (exists && found->first != longest))
+            mismatches++;
+    }
+
+    ok &= mismatches == 0;
+    std::cout << name << ": " << tree.size() << " keys, " << mismatches << " mismatches, " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+
+    ok &= run<std::u16string>("u16string", random_u16);
+    ok &= run<std::vector<uint8_t>>("vector<uint8_t>", random_bytes);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+// RadixLRUCache 的示例: 随机的 get/put/erase/invalidate_prefix, 与 std::list + std::map 实现的参照 LRU 缓存逐步对照
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "radix_lru_cache.hpp"
+
+typedef RadixLRUCache<std::string, int> cache_type;
+
+// 参照实现: 链表头部是最近使用的, 用 charge 之和与预算比较
+struct ReferenceCache {
+    struct item {
+        std::string key;
+        int value;
+        size_t charge;
+    };
+
+    std::list<item> order;
+    std::map<std::string, std::list<item>::iterator> index;
+    size_t capacity;
+    size_t usage = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+
+    explicit ReferenceCache(size_t capacity)
+        : capacity(capacity) {
+    }
+
+    int* get(const std::string& key) {
+        std::map<std::string, std::list<item>::iterator>::iterator it = index.find(key);
+        if (it == index.end()) {
+            misses++;
+            return NULL;
+        }
+        hits++;
+        order.splice(order.begin(), order, it->second);
+        return &it->second->value;
+    }
+    bool put(const std::string& key, int value, size_t charge) {
+        erase(key);
+        order.push_front(item{key, value, charge});
+        index[key] = order.begin();
+        usage += charge;
+        while (usage > capacity && !order.empty()) {
+            erase(order.back().key);
+            evictions++;
+        }
+        return charge <= capacity;
+    }
+    bool erase(const std::string& key) {
+        std::map<std::string, std::list<item>::iterator>::iterator it = index.find(key);
+        if (it == index.end())
+            return false;
+        usage -= it->second->charge;
+        order.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+    size_t invalidate_prefix(const std::string& prefix) {
+        size_t count = 0;
+        std::map<std::string, std::list<item>::iterator>::iterator it = index.lower_bound(prefix);
+        while (it != index.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+            usage -= it->second->charge;
+            order.erase(it->second);
+            index.erase(it++);
+            count++;
+        }
+        return count;
+    }
+};
+
+std::string random_path(std::mt19937& rng) {
+    static const char* dirs[] = {"/api/", "/api/v1/", "/api/v2/", "/static/", "/"};
+    std::string path = dirs[rng() % 5];
+    path += "abcdefgh"[rng() % 8];
+    path += "xyz"[rng() % 3];
+    return path;
+}
+
+int main() {
+    std::mt19937 rng(37);
+    bool ok = true;
+
+    // 预算约能容纳 30 个平均大小的缓存项, 整个 key 空间有 300 个
+    cache_type cache(30 * 50);
+    ReferenceCache expected(30 * 50);
+
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++) {
+        std::string key = random_path(rng);
+        unsigned op = rng() % 100;
+        if (op < 50) {
+            int* got = cache.get(key);
+            int* want = expected.get(key);
+            if ((got == NULL) != (want == NULL) || (got != NULL && *got != *want))
+                mismatches++;
+        } else if (op < 90) {
+            // 偶尔有超过整个预算的缓存项, 插入后立即被淘汰
+            size_t charge = op == 89 ? 2000 : 1 + rng() % 100;
+            if (cache.put(key, i, charge) != expected.put(key, i, charge))
+                mismatches++;
+        } else if (op < 98) {
+            if (cache.erase(key) != expected.erase(key))
+                mismatches++;
+        } else {
+            std::string prefix = key.substr(0, rng() % key.size());
+            if (cache.invalidate_prefix(prefix) != expected.invalidate_prefix(prefix))
+                mismatches++;
+        }
+
+        if (cache.size() != expected.index.size() || cache.usage() != expected.usage || cache.usage() > cache.capacity())
+            mismatches++;
+    }
+    bool same = cache.hits() == expected.hits && cache.misses() == expected.misses && cache.evictions() == expected.evictions;
+    std::cout << "random operations: " << mismatches << " mismatches, " << cache.hits() << " hits, " << cache.misses() << " misses, "
+              << cache.evictions() << " evictions, " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= mismatches == 0 && same;
+
+    // 缩小预算时立即淘汰最久未使用的缓存项
+    cache.set_capacity(500);
+    expected.capacity = 500;
+    while (expected.usage > expected.capacity) {
+        expected.erase(expected.order.back().key);
+    }
+    same = cache.size() == expected.index.size() && cache.usage() == expected.usage;
+    for (std::map<std::string, std::list<ReferenceCache::item>::iterator>::iterator it = expected.index.begin(); it != expected.index.end(); ++it) {
+        int* got = cache.get(it->first);
+        same &= got != NULL && *got == it->second->value;
+    }
+    std::cout << "set_capacity: " << cache.size() << " entries, " << cache.usage() << " bytes, " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    // charge 为 0 时按内存占用估算
+    cache_type estimated(1 << 20);
+    estimated.put("/api/v1/users", 1);
+    same = estimated.usage() > 0 && *estimated.get("/api/v1/users") == 1;
+    std::cout << "estimated charge: " << estimated.usage() << " bytes, " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
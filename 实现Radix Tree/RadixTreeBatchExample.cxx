@@ -0,0 +1,92 @@
+// RadixTree::insert_batch 的示例: 无序和有序的批量插入, 插入到空树和已有元素的树, 与逐个插入 std::map 的结果对照
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, int> tree_type;
+typedef std::vector<std::pair<std::string, int>> batch_type;
+
+std::string random_key(std::mt19937& rng) {
+    static const char* prefixes[] = {"2024-06-01T", "2024-06-02T", "2024-07-", "event:", ""};
+    std::string key = prefixes[rng() % 5];
+    int len = rng() % 6;
+    for (int i = 0; i < len; i++) {
+        key += "0123:"[rng() % 5];
+    }
+    return key;
+}
+
+batch_type random_batch(std::mt19937& rng, int n, int first_value) {
+    batch_type batch;
+    for (int i = 0; i < n; i++) {
+        batch.push_back(std::make_pair(random_key(rng), first_value + i));
+    }
+    return batch;
+}
+
+// 重复的 key 保留先插入的值, 与 std::map::insert 相同
+size_t expected_insert(std::map<std::string, int>& expected, const batch_type& batch) {
+    size_t count = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        count += expected.insert(batch[i]).second;
+    }
+    return count;
+}
+
+bool check(tree_type& tree, const std::map<std::string, int>& expected, size_t inserted, size_t expected_inserted, const char* step) {
+    bool ok = inserted == expected_inserted && tree.size() == expected.size();
+    std::map<std::string, int>::const_iterator it = expected.begin();
+    for (tree_type::iterator found = tree.begin(); ok && found != tree.end(); ++found, ++it) {
+        ok = found->first == it->first && found->second == it->second;
+    }
+    for (it = expected.begin(); ok && it != expected.end(); ++it) {
+        tree_type::iterator found = tree.find(it->first);
+        ok = found != tree.end() && found->second == it->second;
+    }
+
+    std::cout << step << ": " << inserted << " inserted, " << tree.size() << " keys, " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(38);
+    bool ok = true;
+
+    // 无序的输入, 由 insert_batch 排序
+    tree_type tree;
+    std::map<std::string, int> expected;
+    batch_type batch = random_batch(rng, 30000, 0);
+    size_t inserted = tree.insert_batch(batch);
+    ok &= check(tree, expected, inserted, expected_insert(expected, batch), "unsorted batch");
+
+    // 已经排好序的输入 (稳定排序, 重复的 key 仍然是先出现的排在前面)
+    batch = random_batch(rng, 30000, 100000);
+    std::stable_sort(batch.begin(), batch.end(), [](const std::pair<std::string, int>& a, const std::pair<std::string, int>& b) {
+        return a.first < b.first;
+    });
+    inserted = tree.insert_batch(batch, true);
+    ok &= check(tree, expected, inserted, expected_insert(expected, batch), "sorted batch into non-empty tree");
+
+    // 删除一部分之后再批量插入, 新的 key 会落在合并过的节点上
+    for (int i = 0; i < 10000; i++) {
+        std::string key = random_key(rng);
+        tree.erase(key);
+        expected.erase(key);
+    }
+    batch = random_batch(rng, 10000, 200000);
+    inserted = tree.insert_batch(batch);
+    ok &= check(tree, expected, inserted, expected_insert(expected, batch), "batch after erase");
+
+    // 空的输入
+    inserted = tree.insert_batch(batch_type());
+    ok &= check(tree, expected, inserted, 0, "empty batch");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
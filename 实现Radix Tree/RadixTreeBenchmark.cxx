@@ -0,0 +1,536 @@
+// RadixTree 与 std::map / std::unordered_map / 有序 std::vector 的性能对比
+//
+// 用法: RadixTreeBenchmark [keys] [label] [words_file]
+//     keys        每个语料的 key 个数, 默认 200000
+//     label       写入每条结果的版本标签, 便于跨版本比较, 默认 "dev"
+//     words_file  词典文件, 每行一个单词, 默认 /usr/share/dict/words, 不存在时生成伪单词
+//
+// 每条结果是一行 JSON (JSON Lines), 例如
+//     {"label":"dev","corpus":"urls","container":"radix_tree","op":"find_hit","n":200000,"ops_per_sec":...,"p50_ns":...,"p99_ns":...,"p999_ns":...}
+// 每个 (语料, 容器) 组合在单独的子进程中运行, 子进程只生成自己要测的语料.
+// bytes_per_key 是建好容器前后 mallinfo2() 统计的已分配堆内存之差, 不受页面复用的影响;
+// peak_rss_kb 是生成语料之后到测试结束的峰值 RSS 减去生成语料之后的 RSS, 即容器加上测试中的临时内存
+// (内核不支持 /proc/self/clear_refs 时退化为整个子进程的峰值).
+// 插入和删除会改变容器, 只能测一遍, 它们的吞吐量包含了逐个计时的开销.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "radix_tree.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// 防止结果被编译器优化掉
+static volatile size_t sink;
+
+// 延迟统计最多采样的操作个数
+#define LATENCY_SAMPLES 100000
+
+struct Corpus {
+    std::string name;
+    std::vector<std::string> keys;
+    std::vector<std::string> misses;
+    std::vector<std::string> longest;
+    std::vector<std::string> prefixes;
+};
+
+/************************************ 语料 ************************************/
+
+static std::string random_word(std::mt19937& rng) {
+    static const char* syllables[] = {"ka", "to", "ri", "an", "el", "mo", "su", "ne", "di", "ph", "qu", "st", "ing", "er", "ly", "ion"};
+    std::string word;
+    int n = 1 + rng() % 4;
+    for (int i = 0; i < n; i++) {
+        word += syllables[rng() % 16];
+    }
+    return word;
+}
+
+static std::string random_hex(std::mt19937& rng, int len) {
+    std::string s;
+    for (int i = 0; i < len; i++) {
+        s += "0123456789abcdef"[rng() % 16];
+    }
+    return s;
+}
+
+static std::vector<std::string> words(std::mt19937& rng, size_t n, const std::string& file) {
+    std::vector<std::string> keys;
+    std::ifstream in(file);
+    std::string line;
+    while (keys.size() < n && std::getline(in, line)) {
+        if (!line.empty())
+            keys.push_back(line);
+    }
+    // 词典不够时用伪单词补足, 加上数字后缀保证个数
+    while (keys.size() < n) {
+        keys.push_back(random_word(rng) + (rng() % 2 ? std::to_string(rng() % 1000) : std::string()));
+    }
+    return keys;
+}
+
+static std::vector<std::string> urls(std::mt19937& rng, size_t n) {
+    static const char* hosts[] = {"www.example.com", "api.example.com", "cdn.example.net", "static.example.org", "shop.example.com"};
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        std::string url = std::string("https://") + hosts[rng() % 5];
+        int depth = 1 + rng() % 4;
+        for (int d = 0; d < depth; d++) {
+            url += "/" + random_word(rng);
+        }
+        url += "?id=" + std::to_string(rng() % 100000);
+        keys.push_back(url);
+    }
+    return keys;
+}
+
+static std::vector<std::string> ipv4(std::mt19937& rng, size_t n) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t addr = rng();
+        int len = 8 + rng() % 25;
+        addr &= len == 32 ? 0xffffffffu : ~(0xffffffffu >> len);
+        keys.push_back(std::to_string(addr >> 24) + "." + std::to_string((addr >> 16) & 255) + "." + std::to_string((addr >> 8) & 255) + "."
+                       + std::to_string(addr & 255) + "/" + std::to_string(len));
+    }
+    return keys;
+}
+
+static std::vector<std::string> uuids(std::mt19937& rng, size_t n) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(random_hex(rng, 8) + "-" + random_hex(rng, 4) + "-4" + random_hex(rng, 3) + "-" + random_hex(rng, 4) + "-" + random_hex(rng, 12));
+    }
+    return keys;
+}
+
+// 很长的公共前缀, 只有末尾几段不同
+static std::vector<std::string> long_prefix(std::mt19937& rng, size_t n) {
+    std::vector<std::string> keys;
+    std::string base = "/tenants/0000000042/regions/eu-west-1/clusters/primary/services/";
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(base + random_word(rng) + "/instances/" + std::to_string(rng() % 64) + "/" + random_hex(rng, 6));
+    }
+    return keys;
+}
+
+static Corpus make_corpus(const std::string& name, std::vector<std::string> keys, std::mt19937& rng) {
+    Corpus corpus;
+    corpus.name = name;
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), rng);
+    corpus.keys = keys;
+
+    size_t queries = std::min<size_t>(keys.size(), LATENCY_SAMPLES);
+    for (size_t i = 0; i < queries; i++) {
+        const std::string& key = keys[rng() % keys.size()];
+        corpus.misses.push_back(key + "#miss");
+        corpus.longest.push_back(key + "/tail");
+        corpus.prefixes.push_back(key.substr(0, key.size() > 3 ? key.size() - 2 : 1));
+    }
+
+    return corpus;
+}
+
+#define CORPORA 5
+
+// 生成第 index 个语料, 每个语料有自己的随机种子, 在子进程中单独生成也能得到相同的 key
+static Corpus build_corpus(int index, size_t n, const std::string& dict) {
+    std::mt19937 rng(20240601 + index);
+    switch (index) {
+    case 0:
+        return make_corpus("words", words(rng, n, dict), rng);
+    case 1:
+        return make_corpus("urls", urls(rng, n), rng);
+    case 2:
+        return make_corpus("ipv4_prefixes", ipv4(rng, n), rng);
+    case 3:
+        return make_corpus("uuids", uuids(rng, n), rng);
+    default:
+        return make_corpus("long_common_prefix", long_prefix(rng, n), rng);
+    }
+}
+
+/************************************ 容器 ************************************/
+
+struct RadixAdapter {
+    static const char* name() {
+        return "radix_tree";
+    }
+    RadixTree<std::string, int> tree;
+
+    void insert(const std::string& key, int value) {
+        tree.insert(std::make_pair(key, value));
+    }
+    void load(const std::vector<std::string>& keys) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            insert(keys[i], i);
+        }
+    }
+    bool find(const std::string& key) {
+        return tree.find(key) != tree.end();
+    }
+    bool longest(const std::string& key) {
+        return tree.longest_match(key) != tree.end();
+    }
+    size_t prefix(const std::string& key) {
+        std::vector<RadixTree<std::string, int>::iterator> vec;
+        tree.prefix_match(key, vec);
+        return vec.size();
+    }
+    size_t iterate() {
+        size_t sum = 0;
+        for (RadixTree<std::string, int>::iterator it = tree.begin(); it != tree.end(); ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    bool erase(const std::string& key) {
+        return tree.erase(key);
+    }
+    static const bool has_prefix = true;
+    static const bool has_erase = true;
+    static const bool bulk_insert = false;
+};
+
+struct MapAdapter {
+    static const char* name() {
+        return "std_map";
+    }
+    std::map<std::string, int> map;
+
+    void insert(const std::string& key, int value) {
+        map.insert(std::make_pair(key, value));
+    }
+    void load(const std::vector<std::string>& keys) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            insert(keys[i], i);
+        }
+    }
+    bool find(const std::string& key) {
+        return map.find(key) != map.end();
+    }
+    // 从长到短依次查找 key 的前缀
+    bool longest(const std::string& key) {
+        for (size_t len = key.size() + 1; len-- > 0;) {
+            if (map.find(key.substr(0, len)) != map.end())
+                return true;
+        }
+        return false;
+    }
+    size_t prefix(const std::string& key) {
+        size_t count = 0;
+        for (std::map<std::string, int>::iterator it = map.lower_bound(key); it != map.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+            count++;
+        }
+        return count;
+    }
+    size_t iterate() {
+        size_t sum = 0;
+        for (std::map<std::string, int>::iterator it = map.begin(); it != map.end(); ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    bool erase(const std::string& key) {
+        return map.erase(key) != 0;
+    }
+    static const bool has_prefix = true;
+    static const bool has_erase = true;
+    static const bool bulk_insert = false;
+};
+
+struct HashAdapter {
+    static const char* name() {
+        return "std_unordered_map";
+    }
+    std::unordered_map<std::string, int> map;
+
+    void insert(const std::string& key, int value) {
+        map.insert(std::make_pair(key, value));
+    }
+    void load(const std::vector<std::string>& keys) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            insert(keys[i], i);
+        }
+    }
+    bool find(const std::string& key) {
+        return map.find(key) != map.end();
+    }
+    bool longest(const std::string& key) {
+        for (size_t len = key.size() + 1; len-- > 0;) {
+            if (map.find(key.substr(0, len)) != map.end())
+                return true;
+        }
+        return false;
+    }
+    // 无序容器没有高效的前缀查询
+    size_t prefix(const std::string&) {
+        return 0;
+    }
+    size_t iterate() {
+        size_t sum = 0;
+        for (std::unordered_map<std::string, int>::iterator it = map.begin(); it != map.end(); ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    bool erase(const std::string& key) {
+        return map.erase(key) != 0;
+    }
+    static const bool has_prefix = false;
+    static const bool has_erase = true;
+    static const bool bulk_insert = false;
+};
+
+struct SortedVectorAdapter {
+    static const char* name() {
+        return "sorted_vector";
+    }
+    std::vector<std::pair<std::string, int>> vec;
+
+    // 逐个插入是 O(n) 的, 这里只测批量构建 (追加后排序)
+    void insert(const std::string& key, int value) {
+        vec.push_back(std::make_pair(key, value));
+    }
+    void load(const std::vector<std::string>& keys) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            insert(keys[i], i);
+        }
+        std::sort(vec.begin(), vec.end());
+    }
+    std::vector<std::pair<std::string, int>>::iterator lower_bound(const std::string& key) {
+        return std::lower_bound(vec.begin(), vec.end(), key, [](const std::pair<std::string, int>& a, const std::string& b) {
+            return a.first < b;
+        });
+    }
+    bool find(const std::string& key) {
+        std::vector<std::pair<std::string, int>>::iterator it = lower_bound(key);
+        return it != vec.end() && it->first == key;
+    }
+    bool longest(const std::string& key) {
+        for (size_t len = key.size() + 1; len-- > 0;) {
+            if (find(key.substr(0, len)))
+                return true;
+        }
+        return false;
+    }
+    size_t prefix(const std::string& key) {
+        size_t count = 0;
+        for (std::vector<std::pair<std::string, int>>::iterator it = lower_bound(key); it != vec.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+            count++;
+        }
+        return count;
+    }
+    size_t iterate() {
+        size_t sum = 0;
+        for (size_t i = 0; i < vec.size(); i++) {
+            sum += vec[i].second;
+        }
+        return sum;
+    }
+    bool erase(const std::string&) {
+        return false;
+    }
+    static const bool has_prefix = true;
+    static const bool has_erase = false;
+    static const bool bulk_insert = true;
+};
+
+/************************************ 计时 ************************************/
+
+// 已分配的堆内存 (包括单独 mmap 的大块)
+static size_t heap_bytes() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// 把 VmHWM 重置为当前 RSS, 失败时返回 false (内核不支持 clear_refs)
+static bool reset_peak_rss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (f == NULL)
+        return false;
+    bool ok = std::fputs("5", f) >= 0;
+    return std::fclose(f) == 0 && ok;
+}
+
+static long peak_rss_kb() {
+    long peak = -1;
+    FILE* f = std::fopen("/proc/self/status", "r");
+    if (f != NULL) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), f) != NULL) {
+            if (std::sscanf(line, "VmHWM: %ld kB", &peak) == 1)
+                break;
+        }
+        std::fclose(f);
+    }
+    if (peak < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        peak = usage.ru_maxrss;
+    }
+    return peak;
+}
+
+static size_t rss_bytes() {
+    long pages = 0, resident = 0;
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (f != NULL) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void report(const std::string& label, const Corpus& corpus, const char* container, const char* op, size_t n, double seconds, std::vector<uint64_t>& latency) {
+    std::printf("{\"label\":\"%s\",\"corpus\":\"%s\",\"container\":\"%s\",\"op\":\"%s\",\"n\":%zu,\"ops_per_sec\":%.0f",
+                label.c_str(), corpus.name.c_str(), container, op, n, seconds > 0 ? n / seconds : 0.0);
+    if (!latency.empty()) {
+        std::sort(latency.begin(), latency.end());
+        std::printf(",\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu",
+                    (unsigned long long)latency[latency.size() / 2],
+                    (unsigned long long)latency[latency.size() * 99 / 100],
+                    (unsigned long long)latency[latency.size() * 999 / 1000]);
+    }
+    std::printf("}\n");
+}
+
+static double since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 只读查询: 先不计时地整体跑一遍得到吞吐量, 再逐个计时得到延迟分布
+template <typename Adapter, typename Op>
+static void query(const std::string& label, const Corpus& corpus, Adapter& adapter, const char* op, const std::vector<std::string>& keys, Op fn) {
+    size_t n = std::min<size_t>(keys.size(), LATENCY_SAMPLES);
+    size_t hits = 0;
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < n; i++) {
+        hits += fn(adapter, keys[i]);
+    }
+    double seconds = since(start);
+
+    std::vector<uint64_t> latency(n);
+    for (size_t i = 0; i < n; i++) {
+        Clock::time_point t = Clock::now();
+        hits += fn(adapter, keys[i]);
+        latency[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+    }
+
+    sink = sink + hits;
+    report(label, corpus, Adapter::name(), op, n, seconds, latency);
+}
+
+template <typename Adapter>
+static void run(const std::string& label, const Corpus& corpus) {
+    Adapter adapter;
+    std::vector<uint64_t> latency;
+    size_t n = corpus.keys.size();
+    // 先把生成语料时释放的内存还给系统, 否则容器会复用这些已经驻留的页面, 峰值 RSS 偏小
+    malloc_trim(0);
+    size_t baseline_kb = rss_bytes() / 1024;
+    if (!reset_peak_rss())
+        baseline_kb = 0;
+    size_t before = heap_bytes();
+
+    Clock::time_point start = Clock::now();
+    if (Adapter::bulk_insert) {
+        adapter.load(corpus.keys);
+    } else {
+        latency.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            Clock::time_point t = Clock::now();
+            adapter.insert(corpus.keys[i], i);
+            latency[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+        }
+    }
+    report(label, corpus, Adapter::name(), "insert", n, since(start), latency);
+
+    size_t loaded = heap_bytes();
+
+    query(label, corpus, adapter, "find_hit", corpus.keys, [](Adapter& a, const std::string& k) {
+        return a.find(k);
+    });
+    query(label, corpus, adapter, "find_miss", corpus.misses, [](Adapter& a, const std::string& k) {
+        return a.find(k);
+    });
+    query(label, corpus, adapter, "longest_match", corpus.longest, [](Adapter& a, const std::string& k) {
+        return a.longest(k);
+    });
+    if (Adapter::has_prefix) {
+        query(label, corpus, adapter, "prefix_match", corpus.prefixes, [](Adapter& a, const std::string& k) {
+            return a.prefix(k);
+        });
+    }
+
+    latency.clear();
+    start = Clock::now();
+    sink = sink + adapter.iterate();
+    report(label, corpus, Adapter::name(), "iterate", n, since(start), latency);
+
+    if (Adapter::has_erase) {
+        latency.resize(n);
+        start = Clock::now();
+        for (size_t i = 0; i < n; i++) {
+            Clock::time_point t = Clock::now();
+            sink = sink + adapter.erase(corpus.keys[i]);
+            latency[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t).count();
+        }
+        report(label, corpus, Adapter::name(), "erase", n, since(start), latency);
+    }
+
+    std::printf("{\"label\":\"%s\",\"corpus\":\"%s\",\"container\":\"%s\",\"op\":\"memory\",\"n\":%zu,\"bytes_per_key\":%.1f,\"peak_rss_kb\":%ld}\n",
+                label.c_str(), corpus.name.c_str(), Adapter::name(), n, n ? (double)(loaded - before) / n : 0.0, peak_rss_kb() - (long)baseline_kb);
+}
+
+// 在子进程中生成语料并运行, 使每个容器的内存统计不包含其他语料和其他容器
+template <typename Adapter>
+static void run_isolated(const std::string& label, int index, size_t n, const std::string& dict) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        run<Adapter>(label, build_corpus(index, n, dict));
+        std::fflush(stdout);
+        _exit(EXIT_SUCCESS);
+    }
+    if (pid > 0) {
+        int status;
+        waitpid(pid, &status, 0);
+    } else {
+        run<Adapter>(label, build_corpus(index, n, dict));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 200000;
+    std::string label = argc > 2 ? argv[2] : "dev";
+    std::string dict = argc > 3 ? argv[3] : "/usr/share/dict/words";
+
+    for (int i = 0; i < CORPORA; i++) {
+        run_isolated<RadixAdapter>(label, i, n, dict);
+        run_isolated<MapAdapter>(label, i, n, dict);
+        run_isolated<HashAdapter>(label, i, n, dict);
+        run_isolated<SortedVectorAdapter>(label, i, n, dict);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+// RadixTree::diff 的示例: 把主节点的修改以差异的形式同步到副本, 差异与按顺序归并两个 std::map 的结果对照
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, int> tree_type;
+typedef std::tuple<RadixDiffKind, std::string, int, int> change_type;
+
+std::string random_key(std::mt19937& rng) {
+    std::string key = rng() % 2 == 0 ? "config/" : "";
+    int len = rng() % 8;
+    for (int i = 0; i < len; i++) {
+        key += "abc/"[rng() % 4];
+    }
+    return key;
+}
+
+// 参照实现: 按 key 的顺序归并两个 std::map; 不存在的一侧的值记为 -1
+std::vector<change_type> expected_diff(const std::map<std::string, int>& a, const std::map<std::string, int>& b) {
+    std::vector<change_type> changes;
+    std::map<std::string, int>::const_iterator i = a.begin(), j = b.begin();
+    while (i != a.end() || j != b.end()) {
+        if (j == b.end() || (i != a.end() && i->first < j->first)) {
+            changes.push_back(change_type(RadixDiffKind::removed, i->first, i->second, -1));
+            ++i;
+        } else if (i == a.end() || j->first < i->first) {
+            changes.push_back(change_type(RadixDiffKind::added, j->first, -1, j->second));
+            ++j;
+        } else {
+            if (i->second != j->second)
+                changes.push_back(change_type(RadixDiffKind::changed, i->first, i->second, j->second));
+            ++i;
+            ++j;
+        }
+    }
+    return changes;
+}
+
+std::vector<change_type> tree_diff(const tree_type& a, const tree_type& b) {
+    std::vector<change_type> changes;
+    tree_type::diff(a, b, [&changes](RadixDiffKind kind, const std::string& key, const int* old_value, const int* new_value) {
+        changes.push_back(change_type(kind, key, old_value != NULL ? *old_value : -1, new_value != NULL ? *new_value : -1));
+    });
+    return changes;
+}
+
+int main() {
+    std::mt19937 rng(39);
+    bool ok = true;
+
+    tree_type primary, replica;
+    std::map<std::string, int> expected_primary, expected_replica;
+
+    for (int round = 0; round < 20; round++) {
+        // 主节点上的一批随机修改
+        for (int i = 0; i < 500; i++) {
+            std::string key = random_key(rng);
+            if (rng() % 4 != 0) {
+                int value = rng() % 5;
+                primary[key] = value;
+                expected_primary[key] = value;
+            } else {
+                primary.erase(key);
+                expected_primary.erase(key);
+            }
+        }
+
+        std::vector<change_type> changes = tree_diff(replica, primary);
+        bool same = changes == expected_diff(expected_replica, expected_primary);
+
+        // 把差异应用到副本上之后, 两棵树没有差异
+        for (size_t i = 0; i < changes.size(); i++) {
+            const std::string& key = std::get<1>(changes[i]);
+            if (std::get<0>(changes[i]) == RadixDiffKind::removed) {
+                replica.erase(key);
+                expected_replica.erase(key);
+            } else {
+                replica[key] = std::get<3>(changes[i]);
+                expected_replica[key] = std::get<3>(changes[i]);
+            }
+        }
+        same &= tree_diff(replica, primary).empty() && tree_diff(primary, primary).empty();
+        same &= expected_replica == expected_primary;
+
+        if (!same || round % 5 == 0)
+            std::cout << "round " << round << ": " << changes.size() << " changes, " << (same ? "ok" : "MISMATCH") << std::endl;
+        ok &= same;
+    }
+
+    // 与空树比较
+    tree_type empty;
+    bool same = tree_diff(empty, primary) == expected_diff(std::map<std::string, int>(), expected_primary);
+    same &= tree_diff(primary, empty) == expected_diff(expected_primary, std::map<std::string, int>());
+    std::cout << "diff with empty tree: " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,177 @@
+// DurableRadixTree 的示例: 写入 -> 关闭 -> 重新打开恢复 -> 快照 -> 再次恢复 -> 日志尾部损坏后恢复
+//
+// 用法: RadixTreeDurableExample [dir]
+//     dir  数据目录, 默认在 /tmp 下新建一个临时目录, 结束后删除
+//
+// 每一步都会检查恢复出来的内容, 与预期不一致时返回 EXIT_FAILURE
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "radix_tree_durable.hpp"
+
+typedef DurableRadixTree<std::string, int> durable_tree;
+
+// 与 DurableRadixTree 做相同操作的参照
+std::map<std::string, int> expected;
+
+void list_files(const std::string& dir) {
+    std::vector<std::string> files;
+    if (DIR* d = ::opendir(dir.c_str())) {
+        struct dirent* entry;
+        while ((entry = ::readdir(d)) != NULL) {
+            if (entry->d_name[0] != '.')
+                files.push_back(entry->d_name);
+        }
+        ::closedir(d);
+    }
+    std::sort(files.begin(), files.end());
+
+    std::cout << "    files:";
+    for (size_t i = 0; i < files.size(); i++) {
+        std::cout << " " << files[i];
+    }
+    std::cout << std::endl;
+}
+
+bool check(durable_tree& tree, const char* step) {
+    bool ok = tree.size() == expected.size();
+    std::map<std::string, int>::iterator it;
+    for (it = expected.begin(); ok && it != expected.end(); ++it) {
+        durable_tree::iterator found = tree.find(it->first);
+        ok = found != tree.end() && found->second == it->second;
+    }
+
+    std::cout << step << ": " << tree.size() << " keys, " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+void insert(durable_tree& tree, const std::string& key, int value) {
+    if (tree.insert(std::make_pair(key, value)).second)
+        expected.insert(std::make_pair(key, value));
+}
+
+void erase(durable_tree& tree, const std::string& key) {
+    tree.erase(key);
+    expected.erase(key);
+}
+
+void remove_dir(const std::string& dir) {
+    if (DIR* d = ::opendir(dir.c_str())) {
+        struct dirent* entry;
+        while ((entry = ::readdir(d)) != NULL) {
+            if (entry->d_name[0] != '.')
+                ::unlink((dir + "/" + entry->d_name).c_str());
+        }
+        ::closedir(d);
+    }
+    ::rmdir(dir.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::string dir;
+    bool temporary = argc < 2;
+    if (temporary) {
+        char name[] = "/tmp/radix_durable_XXXXXX";
+        if (::mkdtemp(name) == NULL) {
+            std::cerr << "cannot create a temporary directory" << std::endl;
+            return EXIT_FAILURE;
+        }
+        dir = name;
+    } else {
+        dir = argv[1];
+    }
+
+    bool ok = true;
+    DurableOptions options;
+    // 只在调用 snapshot() 时生成快照, 输出的文件列表才是确定的
+    options.snapshot_interval = std::chrono::seconds(0);
+
+    {
+        durable_tree tree(dir, options);
+        ok &= check(tree, "open empty");
+
+        insert(tree, "apache", 0);
+        insert(tree, "afford", 1);
+        insert(tree, "available", 2);
+        insert(tree, "affair", 3);
+        insert(tree, "avenger", 4);
+        erase(tree, "afford");
+        ok &= check(tree, "write");
+        list_files(dir);
+    }
+
+    {
+        // 没有快照, 只重放 wal.0
+        durable_tree tree(dir, options);
+        ok &= check(tree, "replay log");
+
+        // 多个线程并发写入, 组提交把它们合并到同一次 fdatasync 中
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.push_back(std::thread([&tree, t] {
+                for (int i = 0; i < 100; i++) {
+                    tree.insert(std::make_pair("key" + std::to_string(t * 100 + i), i));
+                }
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        for (int i = 0; i < 400; i++) {
+            expected.insert(std::make_pair("key" + std::to_string(i), i % 100));
+        }
+        ok &= check(tree, "concurrent write");
+
+        // 快照覆盖了之前所有的日志, 旧日志被删除
+        tree.snapshot();
+        insert(tree, "binary", 5);
+        insert(tree, "bind", 6);
+        erase(tree, "apache");
+        ok &= check(tree, "snapshot");
+        list_files(dir);
+    }
+
+    {
+        // 加载快照后重放快照之后的日志
+        durable_tree tree(dir, options);
+        ok &= check(tree, "load snapshot");
+        insert(tree, "brother", 7);
+        tree.sync();
+    }
+
+    {
+        // 模拟写到一半崩溃: 在最新的日志后面追加不完整的记录, 恢复时会忽略它
+        unsigned long long last = 0;
+        if (DIR* d = ::opendir(dir.c_str())) {
+            struct dirent* entry;
+            while ((entry = ::readdir(d)) != NULL) {
+                if (std::strncmp(entry->d_name, "wal.", 4) == 0)
+                    last = std::max(last, std::strtoull(entry->d_name + 4, NULL, 10));
+            }
+            ::closedir(d);
+        }
+        int fd = ::open((dir + "/wal." + std::to_string(last)).c_str(), O_WRONLY | O_APPEND);
+        if (fd >= 0) {
+            ok &= ::write(fd, "torn", 4) == 4;
+            ::close(fd);
+        }
+
+        durable_tree tree(dir, options);
+        ok &= check(tree, "torn tail");
+    }
+
+    if (temporary)
+        remove_dir(dir);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,83 @@
+// RadixTree::glob_match 的示例: 随机的 key 和通配符模式, 与 fnmatch(3) 逐个匹配的结果对照
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <fnmatch.h>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, int> tree_type;
+
+// key 中包含 '*', 用来检查转义
+std::string random_key(std::mt19937& rng) {
+    static const char alphabet[] = "abc/*";
+    std::string key;
+    int len = rng() % 8;
+    for (int i = 0; i < len; i++) {
+        key += alphabet[rng() % 5];
+    }
+    return key;
+}
+
+std::string random_pattern(std::mt19937& rng) {
+    static const char* parts[] = {"a", "b", "c", "/", "*", "?", "[ab]", "[!a]", "[a-b]", "[!b-c/]", "\\*", "**"};
+    std::string pattern;
+    int len = rng() % 6;
+    for (int i = 0; i < len; i++) {
+        pattern += parts[rng() % 12];
+    }
+    return pattern;
+}
+
+bool check(tree_type& tree, const std::set<std::string>& keys, const std::string& pattern, bool verbose) {
+    std::vector<tree_type::iterator> vec;
+    tree.glob_match(pattern, vec);
+
+    std::set<std::string> found;
+    for (size_t i = 0; i < vec.size(); i++) {
+        found.insert(vec[i]->first);
+    }
+    std::set<std::string> expected;
+    for (std::set<std::string>::const_iterator it = keys.begin(); it != keys.end(); ++it) {
+        if (::fnmatch(pattern.c_str(), it->c_str(), 0) == 0)
+            expected.insert(*it);
+    }
+
+    // 每个匹配的 key 只报告一次
+    bool ok = found == expected && vec.size() == found.size();
+    if (verbose || !ok)
+        std::cout << "glob_match(\"" << pattern << "\"): " << vec.size() << " keys, " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(29);
+    bool ok = true;
+
+    tree_type tree;
+    std::set<std::string> keys;
+    for (int i = 0; i < 3000; i++) {
+        std::string key = random_key(rng);
+        tree[key] = i;
+        keys.insert(key);
+    }
+
+    const char* fixed[] = {"", "*", "a*", "*/*", "a?c", "[ab]*[!c]", "*\\*", "a/*/b", "[a-c][a-c]"};
+    for (size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        ok &= check(tree, keys, fixed[i], true);
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < 2000; i++) {
+        if (!check(tree, keys, random_pattern(rng), false))
+            mismatches++;
+    }
+    std::cout << "random patterns: " << mismatches << " mismatches" << std::endl;
+    ok &= mismatches == 0;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,108 @@
+// RadixTree::parallel_build 和 merge 的示例: 用随机 key 构建和合并, 与 std::map 的结果逐个对照
+//
+// 用法: RadixTreeMergeExample [threads]
+//     threads  parallel_build 使用的线程数, 默认为 0 (硬件线程数)
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, int> tree_type;
+
+// 随机 key: 字母表很小, 长度不一, 有大量的公共前缀和互为前缀的 key
+std::string random_key(std::mt19937& rng) {
+    static const char alphabet[] = "abcd/";
+    std::string key = rng() % 4 == 0 ? "common/prefix/" : "";
+    int len = rng() % 12;
+    for (int i = 0; i < len; i++) {
+        key += alphabet[rng() % 5];
+    }
+    return key;
+}
+
+bool check(tree_type& tree, const std::map<std::string, int>& expected, const char* step) {
+    bool ok = tree.size() == expected.size();
+    // 遍历顺序就是 key 的字典序
+    std::map<std::string, int>::const_iterator it = expected.begin();
+    for (tree_type::iterator found = tree.begin(); ok && found != tree.end(); ++found, ++it) {
+        ok = it != expected.end() && found->first == it->first && found->second == it->second;
+    }
+    for (it = expected.begin(); ok && it != expected.end(); ++it) {
+        tree_type::iterator found = tree.find(it->first);
+        ok = found != tree.end() && found->second == it->second;
+    }
+
+    std::cout << step << ": " << tree.size() << " keys, " << (ok ? "ok" : "MISMATCH") << std::endl;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 0;
+    std::mt19937 rng(26);
+    bool ok = true;
+
+    // parallel_build: 重复的 key 保留先出现的值, 与 std::map::insert 相同
+    std::vector<std::pair<std::string, int>> input;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 50000; i++) {
+        input.push_back(std::make_pair(random_key(rng), i));
+        expected.insert(input.back());
+    }
+    tree_type built;
+    built.parallel_build(input, threads);
+    ok &= check(built, expected, "parallel_build");
+
+    // 只有一个分片, 或者所有 key 都有很长的公共前缀时, 也要得到同样的结果
+    std::vector<std::pair<std::string, int>> prefixed;
+    std::map<std::string, int> expected_prefixed;
+    for (int i = 0; i < 5000; i++) {
+        prefixed.push_back(std::make_pair("common/prefix/common/prefix/" + random_key(rng), i));
+        expected_prefixed.insert(prefixed.back());
+    }
+    tree_type long_prefix;
+    long_prefix.parallel_build(prefixed, threads);
+    ok &= check(long_prefix, expected_prefixed, "parallel_build, long prefix");
+
+    // merge: 两棵树的 key 部分重叠, 重复的 key 保留本树的值, other 被清空
+    tree_type a, b;
+    std::map<std::string, int> expected_a, expected_b;
+    for (int i = 0; i < 20000; i++) {
+        std::string key = random_key(rng);
+        if (rng() % 2 == 0) {
+            a[key] = i;
+            expected_a[key] = i;
+        } else {
+            b[key] = -i;
+            expected_b[key] = -i;
+        }
+    }
+    expected_a.insert(expected_b.begin(), expected_b.end());
+    a.merge(std::move(b));
+    ok &= check(a, expected_a, "merge");
+    ok &= check(b, std::map<std::string, int>(), "merged from");
+
+    // 合并之后的树可以继续修改
+    for (int i = 0; i < 5000; i++) {
+        std::string key = random_key(rng);
+        if (rng() % 2 == 0) {
+            a[key] = i;
+            expected_a[key] = i;
+        } else {
+            a.erase(key);
+            expected_a.erase(key);
+        }
+    }
+    ok &= check(a, expected_a, "modify after merge");
+
+    // 合并进空树时直接接管整棵树
+    tree_type empty;
+    empty.merge(std::move(built));
+    ok &= check(empty, expected, "merge into empty");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,97 @@
+// RadixTree::parallel_for_each 和 parallel_reduce 的示例: 并行遍历和按前缀 map-reduce, 与顺序遍历 std::map 的结果对照
+//
+// 用法: RadixTreeParallelExample [threads]
+//     threads  使用的线程数, 默认为 0 (硬件线程数)
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, long> tree_type;
+
+std::string random_key(std::mt19937& rng) {
+    static const char* dirs[] = {"usr/", "usr/lib/", "usr/local/", "var/log/", "home/", ""};
+    std::string key = dirs[rng() % 6];
+    int len = 1 + rng() % 8;
+    for (int i = 0; i < len; i++) {
+        key += "abcdef"[rng() % 6];
+    }
+    return key;
+}
+
+// 顺序计算 prefix 下所有值的和与个数
+std::pair<long, long> expected_reduce(const std::map<std::string, long>& expected, const std::string& prefix) {
+    std::pair<long, long> result(0, 0);
+    for (std::map<std::string, long>::const_iterator it = expected.lower_bound(prefix); it != expected.end(); ++it) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0)
+            break;
+        result.first += it->second;
+        result.second++;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 0;
+    std::mt19937 rng(27);
+    bool ok = true;
+
+    tree_type tree;
+    std::map<std::string, long> expected;
+    for (long i = 0; i < 100000; i++) {
+        std::string key = random_key(rng);
+        tree[key] = i;
+        expected[key] = i;
+    }
+
+    // parallel_for_each: 每个元素恰好访问一次, 可以修改值
+    std::atomic<long> visited(0);
+    tree.parallel_for_each([&visited](tree_type::value_type& val) {
+        val.second *= 2;
+        visited.fetch_add(1, std::memory_order_relaxed);
+    }, threads);
+    bool same = visited.load() == (long)expected.size();
+    for (std::map<std::string, long>::iterator it = expected.begin(); it != expected.end(); ++it) {
+        it->second *= 2;
+        tree_type::iterator found = tree.find(it->first);
+        same &= found != tree.end() && found->second == it->second;
+    }
+    std::cout << "parallel_for_each: " << visited.load() << " visited, " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    // parallel_reduce: 前缀可以落在边标签的中间, 也可以是不存在的前缀
+    const char* prefixes[] = {"", "usr/", "usr/l", "usr/lib/a", "var/log/", "home/f", "ab", "none/"};
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        std::pair<long, long> result = tree.parallel_reduce(
+            prefixes[i],
+            [](tree_type::value_type& val) {
+                return std::pair<long, long>(val.second, 1);
+            },
+            [](const std::pair<long, long>& x, const std::pair<long, long>& y) {
+                return std::pair<long, long>(x.first + y.first, x.second + y.second);
+            },
+            threads);
+        same = result == expected_reduce(expected, prefixes[i]);
+        std::cout << "parallel_reduce(\"" << prefixes[i] << "\"): " << result.second << " keys, sum " << result.first << ", "
+                  << (same ? "ok" : "MISMATCH") << std::endl;
+        ok &= same;
+    }
+
+    // 空树
+    tree_type empty;
+    long count = 0;
+    empty.parallel_for_each([&count](tree_type::value_type&) {
+        count++;
+    }, threads);
+    long sum = empty.parallel_reduce("", [](tree_type::value_type& val) { return val.second; }, [](long x, long y) { return x + y; }, threads);
+    same = count == 0 && sum == 0;
+    std::cout << "empty tree: " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+// RadixTree::stats() 和操作计数器的示例: 随机修改之后检查统计之间的恒等关系, 计数器与实际调用的次数对照
+#define RADIX_TREE_COUNTERS
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "radix_tree.hpp"
+
+typedef RadixTree<std::string, int> tree_type;
+
+std::string random_key(std::mt19937& rng) {
+    std::string key;
+    int len = 1 + rng() % 10;
+    for (int i = 0; i < len; i++) {
+        key += "abc"[rng() % 3];
+    }
+    return key;
+}
+
+size_t sum(const std::map<size_t, size_t>& histogram, bool weighted) {
+    size_t total = 0;
+    for (std::map<size_t, size_t>::const_iterator it = histogram.begin(); it != histogram.end(); ++it) {
+        total += weighted ? it->first * it->second : it->second;
+    }
+    return total;
+}
+
+void print(const RadixTreeStats& stats) {
+    std::cout << "    keys " << stats.keys << ", nodes " << stats.nodes << " (" << stats.internal << " internal, " << stats.leaves << " leaves), "
+              << stats.bytes_per_key << " bytes/key" << std::endl;
+    std::cout << "    fanout:";
+    for (std::map<size_t, size_t>::const_iterator it = stats.fanout.begin(); it != stats.fanout.end(); ++it) {
+        std::cout << " " << it->first << "x" << it->second;
+    }
+    std::cout << std::endl;
+}
+
+bool check(tree_type& tree, size_t keys, const char* step) {
+    RadixTreeStats stats = tree.stats();
+    bool ok = stats.keys == keys && stats.keys == tree.size();
+    // 每个 key 对应一个叶子, 除根节点外每个节点都是某个内部节点的子节点
+    ok &= stats.leaves == stats.keys && stats.nodes == stats.leaves + stats.internal;
+    ok &= sum(stats.depth, false) == stats.leaves;
+    ok &= stats.nodes == 0 || sum(stats.fanout, true) == stats.nodes - 1;
+    ok &= sum(stats.fanout, false) == stats.internal;
+    // 根节点没有边标签
+    ok &= stats.internal == 0 || sum(stats.label_length, false) == stats.internal - 1;
+    ok &= stats.total_bytes >= stats.node_bytes + stats.label_bytes + stats.map_bytes + stats.value_bytes;
+    ok &= stats.keys == 0 || stats.bytes_per_key == static_cast<double>(stats.total_bytes) / stats.keys;
+
+    std::cout << step << ": " << (ok ? "ok" : "MISMATCH") << std::endl;
+    print(stats);
+    return ok;
+}
+
+int main() {
+    std::mt19937 rng(32);
+    bool ok = true;
+
+    tree_type tree;
+    ok &= check(tree, 0, "empty");
+
+    std::map<std::string, int> expected;
+    size_t finds = 0, inserts = 0, erases = 0;
+    for (int i = 0; i < 20000; i++) {
+        std::string key = random_key(rng);
+        switch (rng() % 3) {
+        case 0:
+            tree.insert(std::make_pair(key, i));
+            expected.insert(std::make_pair(key, i));
+            inserts++;
+            break;
+        case 1:
+            // 只统计真正删除了元素的调用
+            if (tree.erase(key))
+                erases++;
+            expected.erase(key);
+            break;
+        default:
+            tree.find(key);
+            finds++;
+            break;
+        }
+    }
+    ok &= check(tree, expected.size(), "random");
+
+    RadixTreeCounters counters = tree.stats().counters;
+    bool same = counters.finds == finds && counters.inserts == inserts && counters.erases == erases;
+    std::cout << "counters: finds " << counters.finds << ", inserts " << counters.inserts << ", erases " << counters.erases << ", splits "
+              << counters.splits << ", merges " << counters.merges << ", " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    tree.reset_counters();
+    counters = tree.stats().counters;
+    same = counters.finds == 0 && counters.inserts == 0 && counters.erases == 0 && counters.splits == 0 && counters.merges == 0;
+    std::cout << "reset_counters: " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,72 @@
+// StaticRadixTree 的示例: 编译期构建的关键字表, 查找和最长前缀匹配与 std::map 和逐个比较的结果对照
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "static_radix_tree.hpp"
+
+// HTTP 方法和几个互为前缀的关键字
+using Keyword = StaticRadixTree<"GET", "POST", "PUT", "PATCH", "DELETE", "HEAD", "OPTIONS", "CONNECT", "TRACE",
+                                "P", "PO", "HEADER", "">;
+
+// 查找在编译期完成
+static_assert(Keyword::find("POST") == 1);
+static_assert(Keyword::find("POS") == -1);
+static_assert(Keyword::find("") == 12);
+static_assert(Keyword::longest_match("HEADERS") == 11);
+static_assert(Keyword::longest_match("PU") == 9);
+
+// 参照实现: 逐个比较所有关键字, 返回最长的前缀的下标
+int reference_longest_match(std::string_view text) {
+    int best = -1;
+    for (std::size_t i = 0; i < Keyword::key_count; i++) {
+        std::string_view key = Keyword::key(i);
+        if (text.substr(0, key.size()) == key && (best < 0 || key.size() > Keyword::key(best).size()))
+            best = i;
+    }
+    return best;
+}
+
+int main() {
+    std::mt19937 rng(31);
+    bool ok = true;
+
+    std::map<std::string, int> expected;
+    for (std::size_t i = 0; i < Keyword::key_count; i++) {
+        expected[std::string(Keyword::key(i))] = i;
+    }
+
+    // 所有关键字, 关键字的前缀和加长一个字符的 key
+    int mismatches = 0;
+    for (std::size_t i = 0; i < Keyword::key_count; i++) {
+        std::string key(Keyword::key(i));
+        for (std::size_t len = 0; len <= key.size() + 1; len++) {
+            std::string probe = len <= key.size() ? key.substr(0, len) : key + "X";
+            std::map<std::string, int>::iterator it = expected.find(probe);
+            int want = it != expected.end() ? it->second : -1;
+            if (Keyword::find(probe) != want || Keyword::contains(probe) != (want >= 0))
+                mismatches++;
+        }
+    }
+    std::cout << "find: " << mismatches << " mismatches" << std::endl;
+    ok &= mismatches == 0;
+
+    // 随机文本的最长前缀匹配
+    mismatches = 0;
+    for (int i = 0; i < 100000; i++) {
+        std::string text;
+        int len = rng() % 10;
+        for (int j = 0; j < len; j++) {
+            text += "GEPOSTUHADR"[rng() % 11];
+        }
+        if (Keyword::longest_match(text) != reference_longest_match(text))
+            mismatches++;
+    }
+    std::cout << "longest_match: " << mismatches << " mismatches" << std::endl;
+    ok &= mismatches == 0;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
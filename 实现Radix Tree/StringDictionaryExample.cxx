@@ -0,0 +1,120 @@
+// StringDictionary 的示例: 编码一列字符串 -> freeze() 重新编号 -> 按前缀取编号区间 -> 多个线程并发查找,
+// 每一步与 std::map 和有序的 std::vector 对照
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "string_dictionary.hpp"
+
+std::string random_word(std::mt19937& rng) {
+    static const char* stems[] = {"user", "user_id", "url", "uri", "status", "state", ""};
+    std::string word = stems[rng() % 7];
+    int len = rng() % 4;
+    for (int i = 0; i < len; i++) {
+        word += "abc_"[rng() % 4];
+    }
+    return word;
+}
+
+int main() {
+    std::mt19937 rng(36);
+    bool ok = true;
+
+    // 编码一列有大量重复的字符串, 相同的字符串得到相同的编号, 编号从 0 开始连续分配
+    StringDictionary dict;
+    std::map<std::string, uint32_t> expected;
+    std::vector<std::string> column;
+    std::vector<uint32_t> encoded;
+    bool same = true;
+    for (int i = 0; i < 50000; i++) {
+        std::string word = random_word(rng);
+        uint32_t id = dict.encode(word);
+        std::map<std::string, uint32_t>::iterator it = expected.insert(std::make_pair(word, (uint32_t)expected.size())).first;
+        same &= id == it->second;
+        column.push_back(word);
+        encoded.push_back(id);
+    }
+    for (size_t i = 0; i < column.size(); i++) {
+        same &= dict.decode(encoded[i]) == column[i] && dict.lookup(column[i]) == encoded[i];
+    }
+    same &= dict.size() == expected.size() && dict.lookup("missing") == StringDictionary::npos;
+    try {
+        dict.decode(dict.size());
+        same = false;
+    } catch (const std::out_of_range&) {
+    }
+    std::cout << "encode: " << column.size() << " strings, " << dict.size() << " distinct, " << dict.bytes() << " bytes, "
+              << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    // freeze() 之后编号就是字典序的名次, 用返回的映射改写已经编码的列
+    std::vector<uint32_t> remap = dict.freeze();
+    std::vector<std::string> sorted;
+    for (std::map<std::string, uint32_t>::iterator it = expected.begin(); it != expected.end(); ++it) {
+        sorted.push_back(it->first);
+    }
+    same = remap.size() == sorted.size();
+    for (size_t i = 0; same && i < column.size(); i++) {
+        encoded[i] = remap[encoded[i]];
+        same &= dict.decode(encoded[i]) == column[i] && sorted[encoded[i]] == column[i];
+    }
+    std::cout << "freeze: " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    // 前缀对应连续的编号区间
+    const char* prefixes[] = {"", "u", "user", "user_", "ur", "st", "stat", "status_", "x"};
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        std::string prefix = prefixes[i];
+        std::pair<uint32_t, uint32_t> range = dict.prefix_range(prefix);
+        uint32_t first = std::lower_bound(sorted.begin(), sorted.end(), prefix) - sorted.begin();
+        uint32_t last = first;
+        while (last < sorted.size() && sorted[last].compare(0, prefix.size(), prefix) == 0) {
+            last++;
+        }
+        same = range.first == first && range.second == last;
+        std::cout << "prefix_range(\"" << prefix << "\"): [" << range.first << ", " << range.second << "), " << (same ? "ok" : "MISMATCH")
+                  << std::endl;
+        ok &= same;
+    }
+
+    // freeze() 之后新编码的字符串排在有序区间之后, 不在 prefix_range 的结果中
+    std::pair<uint32_t, uint32_t> before = dict.prefix_range("user");
+    uint32_t id = dict.encode("user_new_string");
+    same = id == sorted.size() && dict.prefix_range("user") == before;
+    std::cout << "encode after freeze: " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    // 多个线程同时查找和解码, 同时有一个线程在编码新的字符串
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread([&, t] {
+            for (size_t i = t; i < column.size(); i += 4) {
+                if (dict.lookup(column[i]) != encoded[i] || dict.decode(encoded[i]) != column[i])
+                    errors++;
+            }
+        }));
+    }
+    threads.push_back(std::thread([&dict] {
+        for (int i = 0; i < 1000; i++) {
+            dict.encode("writer_" + std::to_string(i));
+        }
+    }));
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    same = errors.load() == 0 && dict.size() == sorted.size() + 1001;
+    std::cout << "concurrent lookup: " << errors.load() << " errors, " << (same ? "ok" : "MISMATCH") << std::endl;
+    ok &= same;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
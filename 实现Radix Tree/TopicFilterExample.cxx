@@ -0,0 +1,118 @@
+// TopicFilterIndex 的示例: 随机的订阅和主题, 与逐个过滤器按 MQTT 规则匹配的结果对照
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "radix_topic_filter.hpp"
+
+typedef TopicFilterIndex<int> index_type;
+
+std::string random_topic(std::mt19937& rng, bool filter) {
+    static const char* levels[] = {"home", "office", "sensor", "temp", "", "$SYS"};
+    std::string topic;
+    int len = 1 + rng() % 4;
+    for (int i = 0; i < len; i++) {
+        if (i > 0)
+            topic += "/";
+        unsigned r = rng() % 10;
+        if (filter && r == 8) {
+            topic += "+";
+        } else if (filter && r == 9) {
+            topic += "#";
+            break;
+        } else {
+            // "$SYS" 只出现在首层
+            topic += levels[rng() % (i == 0 ? 6 : 5)];
+        }
+    }
+    return topic;
+}
+
+// 参照实现: 逐层比较一个过滤器和主题
+bool reference_match(const std::string& filter, const std::string& topic) {
+    TopicKey f = index_type::split(filter);
+    TopicKey t = index_type::split(topic);
+    bool system = !t[0].empty() && t[0][0] == '$';
+
+    for (size_t i = 0; i < f.size(); i++) {
+        if (f[i] == "#")
+            return !(i == 0 && system);
+        if (i >= t.size())
+            return false;
+        if (f[i] == "+") {
+            if (i == 0 && system)
+                return false;
+        } else if (f[i] != t[i]) {
+            return false;
+        }
+    }
+    return f.size() == t.size();
+}
+
+int main() {
+    std::mt19937 rng(30);
+    bool ok = true;
+
+    index_type index;
+    std::map<std::string, int> filters;
+    for (int i = 0; i < 500; i++) {
+        std::string filter = random_topic(rng, true);
+        if (index.subscribe(filter, i).second)
+            filters[filter] = i;
+    }
+    // 取消一部分订阅
+    for (int i = 0; i < 100; i++) {
+        std::string filter = random_topic(rng, true);
+        bool erased = index.unsubscribe(filter);
+        ok &= erased == (filters.erase(filter) == 1);
+    }
+    std::cout << "subscribe: " << index.size() << " filters, " << (index.size() == filters.size() ? "ok" : "MISMATCH") << std::endl;
+    ok &= index.size() == filters.size();
+
+    // 不合法的过滤器
+    const char* invalid[] = {"home/#/temp", "home/te+", "sensor#"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        bool thrown = false;
+        try {
+            index.subscribe(invalid[i], 0);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        std::cout << "subscribe(\"" << invalid[i] << "\"): " << (thrown ? "rejected" : "ACCEPTED") << std::endl;
+        ok &= thrown;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < 5000; i++) {
+        std::string topic = random_topic(rng, false);
+        std::vector<index_type::iterator> vec;
+        index.match(topic, vec);
+
+        std::set<std::string> found;
+        for (size_t j = 0; j < vec.size(); j++) {
+            std::string filter;
+            for (size_t k = 0; k < vec[j]->first.size(); k++) {
+                filter += (k > 0 ? "/" : "") + vec[j]->first[k];
+            }
+            found.insert(filter);
+        }
+        std::set<std::string> expected;
+        for (std::map<std::string, int>::iterator it = filters.begin(); it != filters.end(); ++it) {
+            if (reference_match(it->first, topic))
+                expected.insert(it->first);
+        }
+        if (found != expected || vec.size() != found.size()) {
+            std::cout << "match(\"" << topic << "\"): MISMATCH" << std::endl;
+            mismatches++;
+        }
+    }
+    std::cout << "match: " << mismatches << " mismatches" << std::endl;
+    ok &= mismatches == 0;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
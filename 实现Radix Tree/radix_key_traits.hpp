@@ -0,0 +1,189 @@
+#ifndef RADIX_KEY_TRAITS_HPP
+#define RADIX_KEY_TRAITS_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// RadixTree 对 key 类型的所有操作都通过 radix_key_traits<K> 完成.
+// 已经支持 std::basic_string<CharT> (string, u16string, u32string, wstring)
+// 和 std::vector<E> (vector<uint8_t> 等二进制 key, 以及 TopicKey 这种多层 key).
+// 边标签需要可变长度, std::array 这类定长类型不能直接作为 key, 二进制数据请用 vector<uint8_t>.
+// 其他类型可以特化 radix_key_traits, 提供与下面相同的静态成员
+template <typename K>
+struct radix_key_traits;
+
+// 64 位整数的最终混合 (MurmurHash3 fmix64), std::hash 对整数等类型可能是恒等映射, 混合一次使高低位都均匀
+inline uint64_t radix_mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+template <typename CharT, typename Traits, typename Alloc>
+struct radix_key_traits<std::basic_string<CharT, Traits, Alloc>> {
+    using key_type = std::basic_string<CharT, Traits, Alloc>;
+    using element_type = CharT;
+
+    static int length(const key_type& key) {
+        return key.size();
+    }
+    static element_type at(const key_type& key, int i) {
+        return key[i];
+    }
+    static key_type substr(const key_type& key, int begin, int num) {
+        return key.substr(begin, num);
+    }
+    static key_type join(const key_type& key1, const key_type& key2) {
+        return key1 + key2;
+    }
+    // key 从 begin 开始的 length(label) 个元素是否等于 label, 不构造子串
+    static bool equal_at(const key_type& key, int begin, const key_type& label) {
+        return begin + label.size() <= key.size() && Traits::compare(key.data() + begin, label.data(), label.size()) == 0;
+    }
+    // key 从 begin 开始与 label 的公共前缀长度
+    static int common_prefix(const key_type& key, int begin, const key_type& label) {
+        size_t len = std::min(key.size() - std::min<size_t>(begin, key.size()), label.size());
+        const CharT* p = key.data() + begin;
+        return std::mismatch(p, p + len, label.data(), [](CharT a, CharT b) { return Traits::eq(a, b); }).first - p;
+    }
+    // key 在对象本身之外占用的堆内存, 用于 stats() 的内存统计
+    static size_t heap_bytes(const key_type& key) {
+        // 短字符串存放在对象内部 (SSO), 不占用堆内存
+        const char* begin = reinterpret_cast<const char*>(&key);
+        const char* data = reinterpret_cast<const char*>(key.data());
+        if (data >= begin && data < begin + sizeof(key))
+            return 0;
+        return (key.capacity() + 1) * sizeof(CharT);
+    }
+    static uint64_t hash(const key_type& key) {
+        std::string_view bytes(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(CharT));
+        return radix_mix64(std::hash<std::string_view>()(bytes));
+    }
+};
+
+template <typename E, typename Alloc>
+struct radix_key_traits<std::vector<E, Alloc>> {
+    using key_type = std::vector<E, Alloc>;
+    using element_type = E;
+
+    static int length(const key_type& key) {
+        return key.size();
+    }
+    static const element_type& at(const key_type& key, int i) {
+        return key[i];
+    }
+    static key_type substr(const key_type& key, int begin, int num) {
+        int end = begin + num;
+        if (end > static_cast<int>(key.size()))
+            end = key.size();
+        return key_type(key.begin() + begin, key.begin() + end);
+    }
+    static key_type join(const key_type& key1, const key_type& key2) {
+        key_type key;
+        key.reserve(key1.size() + key2.size());
+        key.insert(key.end(), key1.begin(), key1.end());
+        key.insert(key.end(), key2.begin(), key2.end());
+        return key;
+    }
+    static bool equal_at(const key_type& key, int begin, const key_type& label) {
+        return begin + label.size() <= key.size() && std::equal(label.begin(), label.end(), key.begin() + begin);
+    }
+    static int common_prefix(const key_type& key, int begin, const key_type& label) {
+        size_t len = std::min(key.size() - std::min<size_t>(begin, key.size()), label.size());
+        return std::mismatch(label.begin(), label.begin() + len, key.begin() + begin).first - label.begin();
+    }
+    static size_t heap_bytes(const key_type& key) {
+        size_t bytes = key.capacity() * sizeof(E);
+        if constexpr (requires(const E& e) { radix_key_traits<E>::heap_bytes(e); }) {
+            for (size_t i = 0; i < key.size(); i++) {
+                bytes += radix_key_traits<E>::heap_bytes(key[i]);
+            }
+        }
+        return bytes;
+    }
+    static uint64_t hash(const key_type& key) {
+        if constexpr (std::is_integral<E>::value) {
+            // 整数元素直接按字节哈希
+            std::string_view bytes(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(E));
+            return radix_mix64(std::hash<std::string_view>()(bytes));
+        } else {
+            uint64_t h = key.size();
+            for (size_t i = 0; i < key.size(); i++) {
+                uint64_t elem;
+                if constexpr (requires(const E& e) { radix_key_traits<E>::hash(e); })
+                    elem = radix_key_traits<E>::hash(key[i]);
+                else
+                    elem = radix_mix64(std::hash<E>()(key[i]));
+                h = (h ^ elem) * 0x100000001b3ULL;
+            }
+            return radix_mix64(h);
+        }
+    }
+};
+
+// 可以作为 RadixTree key 的类型
+template <typename K>
+concept RadixKey = std::totally_ordered<K> && requires(const K& key, int i) {
+    typename radix_key_traits<K>::element_type;
+    { radix_key_traits<K>::length(key) } -> std::convertible_to<int>;
+    { radix_key_traits<K>::at(key, i) } -> std::convertible_to<typename radix_key_traits<K>::element_type>;
+    { radix_key_traits<K>::substr(key, i, i) } -> std::same_as<K>;
+    { radix_key_traits<K>::join(key, key) } -> std::same_as<K>;
+    { radix_key_traits<K>::equal_at(key, i, key) } -> std::same_as<bool>;
+    { radix_key_traits<K>::common_prefix(key, i, key) } -> std::convertible_to<int>;
+    { radix_key_traits<K>::heap_bytes(key) } -> std::convertible_to<size_t>;
+    { radix_key_traits<K>::hash(key) } -> std::convertible_to<uint64_t>;
+};
+
+template <typename K>
+K radix_substr(const K& key, int begin, int num) {
+    return radix_key_traits<K>::substr(key, begin, num);
+}
+
+template <typename K>
+K radix_join(const K& key1, const K& key2) {
+    return radix_key_traits<K>::join(key1, key2);
+}
+
+template <typename K>
+int radix_length(const K& key) {
+    return radix_key_traits<K>::length(key);
+}
+
+template <typename K>
+typename radix_key_traits<K>::element_type radix_at(const K& key, int i) {
+    return radix_key_traits<K>::at(key, i);
+}
+
+template <typename K>
+bool radix_equal_at(const K& key, int begin, const K& label) {
+    return radix_key_traits<K>::equal_at(key, begin, label);
+}
+
+template <typename K>
+int radix_common_prefix(const K& key, int begin, const K& label) {
+    return radix_key_traits<K>::common_prefix(key, begin, label);
+}
+
+template <typename K>
+size_t radix_heap_bytes(const K& key) {
+    return radix_key_traits<K>::heap_bytes(key);
+}
+
+// key 的 64 位哈希, 供 RadixBloomFilter 使用
+template <typename K>
+uint64_t radix_hash(const K& key) {
+    return radix_key_traits<K>::hash(key);
+}
+
+#endif // RADIX_KEY_TRAITS_HPP
@@ -0,0 +1,195 @@
+#ifndef RADIX_LRU_CACHE_HPP
+#define RADIX_LRU_CACHE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+// 以 RadixTree 为索引的 LRU 缓存, 按内存预算淘汰.
+// 每个叶子的值里嵌入双向链表指针 (侵入式链表), 叶子的 value_type 在堆上单独分配, 地址在树结构变化时不变.
+// invalidate_prefix() 可以一次删除某个前缀下的所有缓存项, 例如父路径的策略变更时.
+// 不是线程安全的
+template <typename K, typename V>
+class RadixLRUCache {
+public:
+    struct link {
+        link* prev;
+        link* next;
+    };
+    struct entry : link {
+        V value;
+        size_t charge;
+        const K* key;
+    };
+
+    using tree_type = RadixTree<K, entry>;
+    using size_type = typename tree_type::size_type;
+
+    explicit RadixLRUCache(size_t capacity)
+        : m_capacity(capacity), m_usage(0), m_hits(0), m_misses(0), m_evictions(0) {
+        m_head.prev = m_head.next = &m_head;
+    }
+
+    size_type size() const {
+        return m_tree.size();
+    }
+    bool empty() const {
+        return m_tree.empty();
+    }
+    size_t capacity() const {
+        return m_capacity;
+    }
+    // 所有缓存项的 charge 之和
+    size_t usage() const {
+        return m_usage;
+    }
+    size_t hits() const {
+        return m_hits;
+    }
+    size_t misses() const {
+        return m_misses;
+    }
+    size_t evictions() const {
+        return m_evictions;
+    }
+
+    // 修改预算, 超出的部分立即淘汰
+    void set_capacity(size_t capacity) {
+        m_capacity = capacity;
+        evict();
+    }
+
+    // 命中时把缓存项移到链表头部并返回值的指针, 指针在缓存项被淘汰或删除之前有效; 未命中返回 NULL
+    V* get(const K& key);
+    // 插入或覆盖缓存项. charge 为 0 时按节点、元素和 key 的堆内存估算.
+    // 返回 false 表示这一项本身超过了预算, 插入后立即被淘汰
+    bool put(const K& key, const V& value, size_t charge = 0);
+    bool erase(const K& key);
+    // 删除所有以 prefix 为前缀的缓存项, 返回删除的个数
+    size_type invalidate_prefix(const K& prefix);
+    void clear() {
+        m_tree.clear();
+        m_head.prev = m_head.next = &m_head;
+        m_usage = 0;
+    }
+
+private:
+    tree_type m_tree;
+    // 链表的哨兵节点, m_head.next 是最近使用的, m_head.prev 是最久未使用的
+    link m_head;
+    size_t m_capacity;
+    size_t m_usage;
+    size_t m_hits;
+    size_t m_misses;
+    size_t m_evictions;
+
+    void unlink(link* e) {
+        e->prev->next = e->next;
+        e->next->prev = e->prev;
+    }
+    void push_front(link* e) {
+        e->prev = &m_head;
+        e->next = m_head.next;
+        m_head.next->prev = e;
+        m_head.next = e;
+    }
+    void remove(entry* e);
+    void evict();
+};
+
+template <typename K, typename V>
+V* RadixLRUCache<K, V>::get(const K& key) {
+    typename tree_type::iterator it = m_tree.find(key);
+
+    if (it == m_tree.end()) {
+        m_misses++;
+        return NULL;
+    }
+
+    m_hits++;
+    entry* e = &it->second;
+    unlink(e);
+    push_front(e);
+
+    return &e->value;
+}
+
+template <typename K, typename V>
+bool RadixLRUCache<K, V>::put(const K& key, const V& value, size_t charge) {
+    if (charge == 0)
+        charge = sizeof(RadixTreeNode<K, entry>) + sizeof(typename tree_type::value_type) + radix_heap_bytes(key);
+
+    typename tree_type::iterator it = m_tree.find(key);
+    entry* e;
+
+    if (it != m_tree.end()) {
+        e = &it->second;
+        e->value = value;
+        m_usage -= e->charge;
+        unlink(e);
+    } else {
+        it = m_tree.insert(typename tree_type::value_type(key, entry{{NULL, NULL}, value, 0, NULL})).first;
+        e = &it->second;
+        e->key = &it->first;
+    }
+
+    e->charge = charge;
+    m_usage += charge;
+    push_front(e);
+
+    // 新插入的项在链表头部, 只有它本身超过预算时才会被淘汰
+    bool kept = charge <= m_capacity;
+    evict();
+
+    return kept;
+}
+
+template <typename K, typename V>
+bool RadixLRUCache<K, V>::erase(const K& key) {
+    typename tree_type::iterator it = m_tree.find(key);
+    if (it == m_tree.end())
+        return false;
+
+    remove(&it->second);
+    return true;
+}
+
+template <typename K, typename V>
+typename RadixLRUCache<K, V>::size_type RadixLRUCache<K, V>::invalidate_prefix(const K& prefix) {
+    std::vector<typename tree_type::iterator> vec;
+    m_tree.prefix_match(prefix, vec);
+
+    // 删除叶子会合并节点, 使其余的迭代器失效, 所以先取出元素的地址 (不受树结构变化影响)
+    std::vector<entry*> entries;
+    entries.reserve(vec.size());
+    for (size_t i = 0; i < vec.size(); i++) {
+        entries.push_back(&vec[i]->second);
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        remove(entries[i]);
+    }
+
+    return entries.size();
+}
+
+template <typename K, typename V>
+void RadixLRUCache<K, V>::remove(entry* e) {
+    unlink(e);
+    m_usage -= e->charge;
+
+    // key 所在的元素会随叶子一起释放, 需要先复制
+    K key = *e->key;
+    m_tree.erase(key);
+}
+
+template <typename K, typename V>
+void RadixLRUCache<K, V>::evict() {
+    while (m_usage > m_capacity && m_head.prev != &m_head) {
+        remove(static_cast<entry*>(m_head.prev));
+        m_evictions++;
+    }
+}
+
+#endif // RADIX_LRU_CACHE_HPP
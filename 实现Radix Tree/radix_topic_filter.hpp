@@ -0,0 +1,152 @@
+#ifndef RADIX_TOPIC_FILTER_HPP
+#define RADIX_TOPIC_FILTER_HPP
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+// 按 '/' 切分后的主题, 每个元素是一层; 作为 RadixTree 的 key 时边标签是若干层组成的序列.
+// key 的各项操作由 radix_key_traits<std::vector<E>> 提供
+using TopicKey = std::vector<std::string>;
+
+// MQTT 风格的订阅过滤器索引: '+' 匹配一层, '#' 匹配剩余的所有层 (包括父层本身),
+// 以 '$' 开头的主题不会被首层的通配符匹配.
+// 匹配时每层最多沿三个分支 (同名的层, '+', '#') 向下查找, 与过滤器总数无关
+template <typename T>
+class TopicFilterIndex {
+public:
+    using tree_type = RadixTree<TopicKey, T>;
+    using value_type = typename tree_type::value_type;
+    using iterator = typename tree_type::iterator;
+    using size_type = typename tree_type::size_type;
+
+    static TopicKey split(const std::string& topic);
+
+    size_type size() const {
+        return m_tree.size();
+    }
+    bool empty() const {
+        return m_tree.empty();
+    }
+    tree_type& tree() {
+        return m_tree;
+    }
+
+    // 过滤器不合法 ('#' 不在最后一层, 或者通配符和其他字符混在同一层) 时抛出 std::invalid_argument
+    std::pair<iterator, bool> subscribe(const std::string& filter, const T& value);
+    bool unsubscribe(const std::string& filter);
+    iterator find(const std::string& filter) {
+        return m_tree.find(split(filter));
+    }
+    iterator end() {
+        return m_tree.end();
+    }
+
+    // 返回所有匹配 topic 的过滤器
+    void match(const std::string& topic, std::vector<iterator>& vec);
+
+private:
+    tree_type m_tree;
+
+    void match(RadixTreeNode<TopicKey, T>* node, const TopicKey& topic, int depth, std::vector<iterator>& vec);
+    void match_edge(RadixTreeNode<TopicKey, T>* node, const std::string& level, const TopicKey& topic, int depth, std::vector<iterator>& vec);
+};
+
+template <typename T>
+TopicKey TopicFilterIndex<T>::split(const std::string& topic) {
+    TopicKey key;
+    std::string::size_type begin = 0, end;
+
+    while ((end = topic.find('/', begin)) != std::string::npos) {
+        key.push_back(topic.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    key.push_back(topic.substr(begin));
+
+    return key;
+}
+
+template <typename T>
+std::pair<typename TopicFilterIndex<T>::iterator, bool> TopicFilterIndex<T>::subscribe(const std::string& filter, const T& value) {
+    TopicKey key = split(filter);
+
+    for (size_t i = 0; i < key.size(); i++) {
+        const std::string& level = key[i];
+        if (level == "#" && i + 1 != key.size())
+            throw std::invalid_argument("TopicFilterIndex: '#' must be the last level: " + filter);
+        if (level.size() > 1 && level.find_first_of("+#") != std::string::npos)
+            throw std::invalid_argument("TopicFilterIndex: wildcard must occupy a whole level: " + filter);
+    }
+
+    return m_tree.insert(value_type(key, value));
+}
+
+template <typename T>
+bool TopicFilterIndex<T>::unsubscribe(const std::string& filter) {
+    return m_tree.erase(split(filter));
+}
+
+template <typename T>
+void TopicFilterIndex<T>::match(const std::string& topic, std::vector<iterator>& vec) {
+    vec.clear();
+
+    if (m_tree.m_root == NULL)
+        return;
+
+    match(m_tree.m_root, split(topic), 0, vec);
+}
+
+template <typename T>
+void TopicFilterIndex<T>::match(RadixTreeNode<TopicKey, T>* node, const TopicKey& topic, int depth, std::vector<iterator>& vec) {
+    int len = topic.size();
+
+    if (depth == len) {
+        typename RadixTreeNode<TopicKey, T>::it_child it = node->m_children.find(TopicKey());
+        if (it != node->m_children.end() && it->second->m_is_leaf)
+            vec.push_back(iterator(it->second));
+        // "a/#" 同样匹配 "a"
+        match_edge(node, "#", topic, depth, vec);
+        return;
+    }
+
+    match_edge(node, topic[depth], topic, depth, vec);
+
+    if (depth == 0 && !topic[0].empty() && topic[0][0] == '$')
+        return;
+
+    if (topic[depth] != "+")
+        match_edge(node, "+", topic, depth, vec);
+    if (topic[depth] != "#")
+        match_edge(node, "#", topic, depth, vec);
+}
+
+// 沿着首层为 level 的那条边向下匹配; 兄弟边的首层互不相同, 至多一条
+template <typename T>
+void TopicFilterIndex<T>::match_edge(RadixTreeNode<TopicKey, T>* node, const std::string& level, const TopicKey& topic, int depth, std::vector<iterator>& vec) {
+    typename RadixTreeNode<TopicKey, T>::it_child it = node->m_children.lower_bound(TopicKey(1, level));
+
+    if (it == node->m_children.end() || it->second->m_is_leaf || it->first[0] != level)
+        return;
+
+    RadixTreeNode<TopicKey, T>* child = it->second;
+    const TopicKey& label = child->m_key;
+    int len = topic.size();
+
+    for (size_t i = 0; i < label.size(); i++) {
+        if (label[i] == "#") {
+            // '#' 只会出现在过滤器的最后一层, 它下面就是叶子
+            match(child, topic, len, vec);
+            return;
+        }
+        if (depth + static_cast<int>(i) >= len)
+            return;
+        if (label[i] != "+" && label[i] != topic[depth + i])
+            return;
+    }
+
+    match(child, topic, depth + label.size(), vec);
+}
+
+#endif // RADIX_TOPIC_FILTER_HPP
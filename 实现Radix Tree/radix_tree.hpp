@@ -1,40 +1,117 @@
 #ifndef RADIX_TREE_HPP
 #define RADIX_TREE_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "radix_key_traits.hpp"
+#include "radix_tree_filter.hpp"
 #include "radix_tree_iterator.hpp"
 #include "radix_tree_node.hpp"
 
-template <typename K>
-K radix_substr(const K& key, int begin, int num);
-
-template <>
-inline std::string radix_substr<std::string>(const std::string& key, int begin, int num) {
-    return key.substr(begin, num);
-}
-
-template <typename K>
-K radix_join(const K& key1, const K& key2);
+// 定义 RADIX_TREE_COUNTERS 后, 各个操作会累计到 RadixTreeCounters 中
+#ifdef RADIX_TREE_COUNTERS
+#define RADIX_TREE_COUNT(field) (m_counters.field.fetch_add(1, std::memory_order_relaxed))
+#else
+#define RADIX_TREE_COUNT(field) ((void)0)
+#endif
+
+struct RadixTreeCounters {
+    size_t finds = 0;
+    size_t inserts = 0;
+    size_t erases = 0;
+    // 拆分边的次数 (插入时的 prepend 和 merge)
+    size_t splits = 0;
+    // 删除时与唯一的子节点合并的次数
+    size_t merges = 0;
+};
 
-template <>
-inline std::string radix_join<std::string>(const std::string& key1, const std::string& key2) {
-    return key1 + key2;
-}
+// RadixTree 内部累计用的计数器. 多个线程可以同时调用 find(), 所以用 relaxed 原子操作累加,
+// 只保证计数不丢失; 读出的各个字段之间不是同一时刻的快照
+struct RadixTreeAtomicCounters {
+    std::atomic<size_t> finds{0};
+    std::atomic<size_t> inserts{0};
+    std::atomic<size_t> erases{0};
+    std::atomic<size_t> splits{0};
+    std::atomic<size_t> merges{0};
+
+    RadixTreeCounters load() const {
+        RadixTreeCounters result;
+        result.finds = finds.load(std::memory_order_relaxed);
+        result.inserts = inserts.load(std::memory_order_relaxed);
+        result.erases = erases.load(std::memory_order_relaxed);
+        result.splits = splits.load(std::memory_order_relaxed);
+        result.merges = merges.load(std::memory_order_relaxed);
+        return result;
+    }
+    void add(const RadixTreeCounters& other) {
+        finds.fetch_add(other.finds, std::memory_order_relaxed);
+        inserts.fetch_add(other.inserts, std::memory_order_relaxed);
+        erases.fetch_add(other.erases, std::memory_order_relaxed);
+        splits.fetch_add(other.splits, std::memory_order_relaxed);
+        merges.fetch_add(other.merges, std::memory_order_relaxed);
+    }
+    void reset() {
+        finds.store(0, std::memory_order_relaxed);
+        inserts.store(0, std::memory_order_relaxed);
+        erases.store(0, std::memory_order_relaxed);
+        splits.store(0, std::memory_order_relaxed);
+        merges.store(0, std::memory_order_relaxed);
+    }
+};
 
-template <typename K>
-int radix_length(const K& key);
+struct RadixTreeStats {
+    size_t keys = 0;
+    size_t nodes = 0;
+    size_t leaves = 0;
+    size_t internal = 0;
+
+    // 子节点个数 -> 内部节点个数
+    std::map<size_t, size_t> fanout;
+    // 边标签长度 -> 边的条数 (不含叶子的空标签)
+    std::map<size_t, size_t> label_length;
+    // 叶子所在的层数 (根节点为 0) -> 叶子个数
+    std::map<size_t, size_t> depth;
+
+    size_t node_bytes = 0;
+    // 边标签的堆内存, 包括 m_key 和 m_children 中的副本
+    size_t label_bytes = 0;
+    // std::map 的红黑树节点开销
+    size_t map_bytes = 0;
+    size_t value_bytes = 0;
+    size_t total_bytes = 0;
+    double bytes_per_key = 0;
+
+    RadixTreeCounters counters;
+};
 
-template <>
-inline int radix_length<std::string>(const std::string& key) {
-    return key.size();
-}
+// diff() 报告的差异类型
+enum class RadixDiffKind {
+    added,
+    removed,
+    changed
+};
 
 template <typename K, typename T>
 class RadixTree {
+    static_assert(RadixKey<K>, "RadixTree: key type needs a radix_key_traits specialization");
+
+    template <typename U>
+    friend class TopicFilterIndex;
+
 public:
     using key_type = K;
     using mapped_type = T;
@@ -43,10 +120,15 @@ public:
     using size_type = std::size_t;
 
     RadixTree()
-        : m_size(0), m_root(NULL) {
+        : m_size(0), m_root(NULL), m_arena_next(NULL), m_arena_end(NULL),
+          m_generation(0), m_compact_next(NULL), m_compacting(false),
+          m_filter(NULL), m_filter_rate(0), m_filter_stale(0) {
     }
     ~RadixTree() {
-        delete m_root;
+        RadixTreeNode<K, T>::destroy(m_root);
+        release(m_arena);
+        release(m_retired);
+        delete m_filter;
     }
 
     size_type size() const {
@@ -56,11 +138,20 @@ public:
         return m_size == 0;
     }
     void clear() {
-        delete m_root;
+        RadixTreeNode<K, T>::destroy(m_root);
         m_root = NULL;
         m_size = 0;
+        release(m_arena);
+        release(m_retired);
+        m_arena_next = m_arena_end = NULL;
+        m_compact_next = NULL;
+        m_compacting = false;
+        if (m_filter != NULL)
+            m_filter->clear();
+        m_filter_stale = 0;
     }
 
+    // 不修改树, 多个线程可以同时调用, 只需要与写操作互斥
     iterator find(const K& key);
     iterator begin();
     iterator end();
@@ -71,18 +162,126 @@ public:
     void prefix_match(const K& key, std::vector<iterator>& vec);
     void greedy_match(const K& key, std::vector<iterator>& vec);
     iterator longest_match(const K& key);
+    // 通配符匹配: * 匹配任意个元素, ? 匹配一个元素, [abc] [a-z] [!a-z] 匹配字符集, \ 转义下一个元素.
+    // 元素必须是整数类型 (各种字符, uint8_t 等), 元素访问和构造 key 都通过 radix_key_traits<K>
+    void glob_match(const K& pattern, std::vector<iterator>& vec)
+        requires std::integral<typename radix_key_traits<K>::element_type>;
 
     T& operator[](const K& lhs);
 
+    // 按 key 的前缀字节分片, 在线程池中并行构建子树, 最后挂到根节点下
+    template <typename Range>
+    void parallel_build(const Range& range, unsigned threads = 0);
+    // 批量插入: 按 key 排序后依次插入, 每个 key 从与上一个 key 共享的最深节点开始查找, 而不是每次从根节点开始.
+    // sorted 为 true 表示 range 已经按 key 排好序. 重复的 key 保留先插入的值, 返回新插入的元素个数
+    template <typename Range>
+    size_type insert_batch(const Range& range, bool sorted = false);
+    // 把 other 的子树直接拼接进来, 只有前缀冲突的部分才逐层合并; 重复的 key 保留本树的值
+    void merge(RadixTree&& other);
+
+    // 节点形状和内存占用的统计, 需要遍历整棵树
+    RadixTreeStats stats() const;
+
+    // 同步遍历两棵树, 按 key 的顺序报告 a → b 的差异: cb(kind, key, old_value, new_value),
+    // added 时 old_value 为 NULL, removed 时 new_value 为 NULL, changed 用 T 的 operator== 判断.
+    // 两棵树的节点不共享, 所以逐层比较所有节点; 边标签不一致的子树退化为按顺序归并两边的叶子
+    template <typename Callback>
+    static void diff(const RadixTree& a, const RadixTree& b, Callback cb);
+
+    // 按深度优先顺序把所有 RadixTreeNode 搬到新的连续内存中, 使遍历节点时重新变成顺序访存.
+    // 只整理节点本身: m_children 的 std::map 节点和元素 (value_type) 仍留在原来的位置, 边标签只是随节点复制一次,
+    // 所以遍历速度只能部分恢复.
+    // max_nodes 为 0 时一次完成; 否则每次最多搬 max_nodes 个节点, 返回 true 表示整理完毕.
+    // 两次调用之间修改树会让下一次调用从根节点重新扫描, 已经搬过的节点直接跳过, 不计入 max_nodes,
+    // 所以即使每次调用之间都有修改, 整理也会在有限次调用后完成.
+    // 被搬动的叶子对应的迭代器会失效, 元素本身 (value_type) 的地址不变
+    bool compact(size_t max_nodes = 0);
+
+    // 在 find() 前面加一个 Bloom 过滤器, 大部分不存在的 key 不需要访问任何节点.
+    // 插入时同步更新; 删除不会清除比特, 累计的删除超过 1/4 或元素个数超过容量时, 由这次写操作重建过滤器.
+    // find() 只读过滤器, 统计用原子操作累加, 启用后多个线程仍然可以同时 find() (与写操作互斥即可)
+    void enable_filter(double fp_rate = 0.01);
+    void disable_filter();
+    RadixFilterStats filter_stats() const {
+        return m_filter_stats.load();
+    }
+    // 计数器 (RADIX_TREE_COUNTERS) 同样用 relaxed 原子操作累加, 不影响并发的 find()
+    void reset_counters() {
+        m_counters.reset();
+    }
+
+    // 并行遍历所有元素, fn 会在多个线程中被并发调用, 调用顺序不确定
+    template <typename Function>
+    void parallel_for_each(Function fn, unsigned threads = 0);
+    // 对以 prefix 为前缀的元素做 map-reduce, combine 需要满足结合律和交换律; 没有元素时返回值初始化的结果
+    template <typename Map, typename Combine>
+    std::decay_t<std::invoke_result_t<Map&, value_type&>> parallel_reduce(const K& prefix, Map map, Combine combine, unsigned threads = 0);
+
 private:
+    using element_type = typename radix_key_traits<K>::element_type;
+
+    // 通配符模式编译后的一个位置
+    struct glob_token {
+        enum kind_type { literal,
+                         any,
+                         star,
+                         range } kind;
+        element_type elem;
+        // literal 对应的单个元素的 key, 用于在子节点中直接定位
+        K key;
+        std::vector<std::pair<element_type, element_type>> ranges;
+        bool negate;
+    };
+
     size_type m_size;
     RadixTreeNode<K, T>* m_root;
+    RadixTreeAtomicCounters m_counters;
+
+    // compact() 使用的连续内存: 当前这一代的内存块, 以及等待整理完成后释放的旧内存块
+    std::vector<void*> m_arena;
+    std::vector<void*> m_retired;
+    char* m_arena_next;
+    char* m_arena_end;
+    unsigned m_generation;
+    RadixTreeNode<K, T>* m_compact_next;
+    bool m_compacting;
+
+    RadixBloomFilter* m_filter;
+    double m_filter_rate;
+    // 上次重建之后删除的元素个数, 以及是否有未经过 insert() 加入的元素 (merge)
+    size_t m_filter_stale;
+    RadixFilterAtomicStats m_filter_stats;
 
     RadixTreeNode<K, T>* begin(RadixTreeNode<K, T>* node);
     RadixTreeNode<K, T>* find_node(const K& key, RadixTreeNode<K, T>* node, int depth);
+    std::pair<iterator, bool> insert_at(RadixTreeNode<K, T>* node, const value_type& val);
     RadixTreeNode<K, T>* append(RadixTreeNode<K, T>* parent, const value_type& val);
     RadixTreeNode<K, T>* prepend(RadixTreeNode<K, T>* node, const value_type& val);
     void greedy_match(RadixTreeNode<K, T>* node, std::vector<iterator>& vec);
+    RadixTreeNode<K, T>* split(RadixTreeNode<K, T>* node, int count);
+    void merge(RadixTreeNode<K, T>* parent, RadixTreeNode<K, T>* child, size_type& moved);
+    RadixTreeNode<K, T>* prefix_node(const K& key);
+    static std::vector<glob_token> glob_compile(const K& pattern);
+    static bool glob_step(const std::vector<glob_token>& tokens, const std::vector<char>& from, element_type elem, std::vector<char>& to);
+    void glob_match(RadixTreeNode<K, T>* node, const std::vector<glob_token>& tokens, const std::vector<char>& states, std::vector<iterator>& vec);
+    template <typename Visit>
+    void parallel_walk(RadixTreeNode<K, T>* node, unsigned threads, Visit& visit);
+    RadixTreeNode<K, T>* relocate(RadixTreeNode<K, T>* node, size_t reserve);
+    static void release(std::vector<void*>& chunks);
+    template <typename Callback>
+    static void diff(const RadixTreeNode<K, T>* a, const RadixTreeNode<K, T>* b, Callback& cb);
+    static void leaves(const RadixTreeNode<K, T>* node, std::vector<const value_type*>& vec);
+    void rebuild_filter();
+    // 写操作之后调用: 累计的删除超过 1/4 或元素个数超过容量时重建过滤器, 让 find() 不需要修改过滤器
+    void refresh_filter() {
+        if (m_filter != NULL && (m_filter_stale * 4 > m_size || m_size > m_filter->capacity()))
+            rebuild_filter();
+    }
+    // 树的结构变化后, 正在进行的增量整理需要从根节点重新扫描
+    void compact_restart() {
+        if (m_compacting)
+            m_compact_next = m_root;
+    }
 
     RadixTree(const RadixTree& other);           // delete
     RadixTree& operator=(const RadixTree other); // delete
@@ -92,25 +291,33 @@ template <typename K, typename T>
 void RadixTree<K, T>::prefix_match(const K& key, std::vector<iterator>& vec) {
     vec.clear();
 
-    if (m_root == NULL)
+    RadixTreeNode<K, T>* node = prefix_node(key);
+
+    if (node == NULL)
         return;
 
+    greedy_match(node, vec);
+}
+
+// 返回包含所有以 key 为前缀的叶子的最小子树, 不存在时返回 NULL
+template <typename K, typename T>
+RadixTreeNode<K, T>* RadixTree<K, T>::prefix_node(const K& key) {
+    if (m_root == NULL)
+        return NULL;
+
     RadixTreeNode<K, T>* node;
-    K key_sub1, key_sub2;
 
     node = find_node(key, m_root, 0);
 
     if (node->m_is_leaf)
         node = node->m_parent;
 
+    // key 剩余的部分需要是边标签的前缀
     int len = radix_length(key) - node->m_depth;
-    key_sub1 = radix_substr(key, node->m_depth, len);
-    key_sub2 = radix_substr(node->m_key, 0, len);
-
-    if (key_sub1 != key_sub2)
-        return;
+    if (len > radix_length(node->m_key) || radix_common_prefix(key, node->m_depth, node->m_key) != len)
+        return NULL;
 
-    greedy_match(node, vec);
+    return node;
 }
 
 template <typename K, typename T>
@@ -119,16 +326,13 @@ typename RadixTree<K, T>::iterator RadixTree<K, T>::longest_match(const K& key)
         return iterator(NULL);
 
     RadixTreeNode<K, T>* node;
-    K key_sub;
 
     node = find_node(key, m_root, 0);
 
     if (node->m_is_leaf)
         return iterator(node);
 
-    key_sub = radix_substr(key, node->m_depth, radix_length(node->m_key));
-
-    if (!(key_sub == node->m_key))
+    if (!radix_equal_at(key, node->m_depth, node->m_key))
         node = node->m_parent;
 
     K nul = radix_substr(key, 0, 0);
@@ -242,12 +446,17 @@ bool RadixTree<K, T>::erase(const K& key) {
     if (!child->m_is_leaf)
         return 0;
 
+    compact_restart();
+
     parent = child->m_parent;
     parent->m_children.erase(nul);
 
-    delete child;
+    RadixTreeNode<K, T>::destroy(child);
 
     m_size--;
+    m_filter_stale++;
+    RADIX_TREE_COUNT(erases);
+    refresh_filter();
 
     if (parent == m_root)
         return 1;
@@ -258,7 +467,7 @@ bool RadixTree<K, T>::erase(const K& key) {
     if (parent->m_children.empty()) {
         grandparent = parent->m_parent;
         grandparent->m_children.erase(parent->m_key);
-        delete parent;
+        RadixTreeNode<K, T>::destroy(parent);
     } else {
         grandparent = parent;
     }
@@ -286,7 +495,8 @@ bool RadixTree<K, T>::erase(const K& key) {
         grandparent->m_parent->m_children.erase(grandparent->m_key);
         grandparent->m_parent->m_children[uncle->m_key] = uncle;
 
-        delete grandparent;
+        RadixTreeNode<K, T>::destroy(grandparent);
+        RADIX_TREE_COUNT(merges);
     }
 
     return 1;
@@ -339,31 +549,15 @@ RadixTreeNode<K, T>* RadixTree<K, T>::append(RadixTreeNode<K, T>* parent, const
 template <typename K, typename T>
 RadixTreeNode<K, T>* RadixTree<K, T>::prepend(RadixTreeNode<K, T>* node, const value_type& val) {
     int count;
-    int len1, len2;
+    int len2;
 
-    len1 = radix_length(node->m_key);
     len2 = radix_length(val.first) - node->m_depth;
 
-    for (count = 0; count < len1 && count < len2; count++) {
-        if (!(node->m_key[count] == val.first[count + node->m_depth]))
-            break;
-    }
+    count = radix_common_prefix(val.first, node->m_depth, node->m_key);
 
     assert(count != 0);
 
-    node->m_parent->m_children.erase(node->m_key);
-
-    RadixTreeNode<K, T>* node_a = new RadixTreeNode<K, T>;
-
-    node_a->m_parent = node->m_parent;
-    node_a->m_key = radix_substr(node->m_key, 0, count);
-    node_a->m_depth = node->m_depth;
-    node_a->m_parent->m_children[node_a->m_key] = node_a;
-
-    node->m_depth += count;
-    node->m_parent = node_a;
-    node->m_key = radix_substr(node->m_key, count, len1 - count);
-    node->m_parent->m_children[node->m_key] = node;
+    RadixTreeNode<K, T>* node_a = split(node, count);
 
     K nul = radix_substr(val.first, 0, 0);
     if (count == len2) {
@@ -400,6 +594,30 @@ RadixTreeNode<K, T>* RadixTree<K, T>::prepend(RadixTreeNode<K, T>* node, const v
     }
 }
 
+// 在 node 的边标签第 count 个元素处断开, 返回新建的中间节点
+template <typename K, typename T>
+RadixTreeNode<K, T>* RadixTree<K, T>::split(RadixTreeNode<K, T>* node, int count) {
+    int len = radix_length(node->m_key);
+
+    RADIX_TREE_COUNT(splits);
+
+    node->m_parent->m_children.erase(node->m_key);
+
+    RadixTreeNode<K, T>* node_a = new RadixTreeNode<K, T>;
+
+    node_a->m_parent = node->m_parent;
+    node_a->m_key = radix_substr(node->m_key, 0, count);
+    node_a->m_depth = node->m_depth;
+    node_a->m_parent->m_children[node_a->m_key] = node_a;
+
+    node->m_depth += count;
+    node->m_parent = node_a;
+    node->m_key = radix_substr(node->m_key, count, len - count);
+    node->m_parent->m_children[node->m_key] = node;
+
+    return node_a;
+}
+
 template <typename K, typename T>
 std::pair<typename RadixTree<K, T>::iterator, bool> RadixTree<K, T>::insert(const value_type& val) {
     if (m_root == NULL) {
@@ -409,36 +627,59 @@ std::pair<typename RadixTree<K, T>::iterator, bool> RadixTree<K, T>::insert(cons
         m_root->m_key = nul;
     }
 
-    RadixTreeNode<K, T>* node = find_node(val.first, m_root, 0);
+    RADIX_TREE_COUNT(inserts);
 
-    if (node->m_is_leaf) {
+    return insert_at(find_node(val.first, m_root, 0), val);
+}
+
+// node 是 find_node() 对 val.first 的返回值
+template <typename K, typename T>
+std::pair<typename RadixTree<K, T>::iterator, bool> RadixTree<K, T>::insert_at(RadixTreeNode<K, T>* node, const value_type& val) {
+    if (node->m_is_leaf)
         return std::pair<iterator, bool>(node, false);
-    } else if (node == m_root) {
-        m_size++;
-        return std::pair<iterator, bool>(append(m_root, val), true);
-    } else {
-        m_size++;
-        int len = radix_length(node->m_key);
-        K key_sub = radix_substr(val.first, node->m_depth, len);
 
-        if (key_sub == node->m_key) {
-            return std::pair<iterator, bool>(append(node, val), true);
-        } else {
-            return std::pair<iterator, bool>(prepend(node, val), true);
-        }
+    compact_restart();
+
+    if (m_filter != NULL)
+        m_filter->add(radix_hash(val.first));
+
+    RadixTreeNode<K, T>* leaf;
+    m_size++;
+
+    if (node == m_root || radix_equal_at(val.first, node->m_depth, node->m_key)) {
+        leaf = append(node, val);
+    } else {
+        leaf = prepend(node, val);
     }
+
+    refresh_filter();
+
+    return std::pair<iterator, bool>(leaf, true);
 }
 
 template <typename K, typename T>
 typename RadixTree<K, T>::iterator RadixTree<K, T>::find(const K& key) {
+    RADIX_TREE_COUNT(finds);
+
     if (m_root == NULL)
         return iterator(NULL);
 
+    if (m_filter != NULL) {
+        m_filter_stats.lookups.fetch_add(1, std::memory_order_relaxed);
+        if (!m_filter->may_contain(radix_hash(key))) {
+            m_filter_stats.negatives.fetch_add(1, std::memory_order_relaxed);
+            return iterator(NULL);
+        }
+    }
+
     RadixTreeNode<K, T>* node = find_node(key, m_root, 0);
 
     // if the node is a internal node, return NULL
-    if (!node->m_is_leaf)
+    if (!node->m_is_leaf) {
+        if (m_filter != NULL)
+            m_filter_stats.false_positives.fetch_add(1, std::memory_order_relaxed);
         return iterator(NULL);
+    }
 
     return iterator(node);
 }
@@ -459,12 +700,9 @@ RadixTreeNode<K, T>* RadixTree<K, T>::find_node(const K& key, RadixTreeNode<K, T
                 continue;
         }
 
-        if (!it->second->m_is_leaf && key[depth] == it->first[0]) {
-            int len_node = radix_length(it->first);
-            K key_sub = radix_substr(key, depth, len_node);
-
-            if (key_sub == it->first) {
-                return find_node(key, it->second, depth + len_node);
+        if (!it->second->m_is_leaf && radix_key_traits<K>::at(key, depth) == radix_key_traits<K>::at(it->first, 0)) {
+            if (radix_equal_at(key, depth, it->first)) {
+                return find_node(key, it->second, depth + radix_length(it->first));
             } else {
                 return it->second;
             }
@@ -474,4 +712,910 @@ RadixTreeNode<K, T>* RadixTree<K, T>::find_node(const K& key, RadixTreeNode<K, T
     return node;
 }
 
+template <typename K, typename T>
+void RadixTree<K, T>::merge(RadixTree&& other) {
+    if (&other == this || other.m_root == NULL)
+        return;
+
+    compact_restart();
+
+    // other 中被 compact() 过的节点会被直接拼接过来, 接管它们所在的内存块
+    m_retired.insert(m_retired.end(), other.m_arena.begin(), other.m_arena.end());
+    m_retired.insert(m_retired.end(), other.m_retired.begin(), other.m_retired.end());
+    other.m_arena.clear();
+    other.m_retired.clear();
+    other.m_arena_next = other.m_arena_end = NULL;
+
+    m_counters.add(other.m_counters.load());
+    other.reset_counters();
+
+    if (m_root == NULL) {
+        m_root = other.m_root;
+        m_size = other.m_size;
+        other.m_root = NULL;
+        other.m_size = 0;
+        other.m_compact_next = NULL;
+        other.m_compacting = false;
+        if (m_filter != NULL)
+            rebuild_filter();
+        return;
+    }
+
+    // 先把 other 的子节点整体摘下来, 再逐个挂到本树上
+    std::map<K, RadixTreeNode<K, T>*> children;
+    children.swap(other.m_root->m_children);
+
+    size_type moved = other.m_size;
+    typename RadixTreeNode<K, T>::it_child it;
+    for (it = children.begin(); it != children.end(); ++it) {
+        merge(m_root, it->second, moved);
+    }
+    m_size += moved;
+
+    // 拼接过来的 key 没有加入过滤器
+    if (m_filter != NULL)
+        rebuild_filter();
+
+    other.clear();
+}
+
+// 把已经摘下来的 child (深度与 parent 的子节点一致) 合并到 parent 下
+template <typename K, typename T>
+void RadixTree<K, T>::merge(RadixTreeNode<K, T>* parent, RadixTreeNode<K, T>* child, size_type& moved) {
+    if (child->m_is_leaf) {
+        if (parent->m_children.count(child->m_key) != 0) {
+            // key 已经存在, 丢弃 other 中的值
+            RadixTreeNode<K, T>::destroy(child);
+            moved--;
+        } else {
+            child->m_parent = parent;
+            parent->m_children[child->m_key] = child;
+        }
+        return;
+    }
+
+    // 找到与 child 首元素相同的非叶子节点, 兄弟节点的首元素互不相同, 至多一个
+    typename RadixTreeNode<K, T>::it_child it;
+    it = parent->m_children.lower_bound(radix_substr(child->m_key, 0, 1));
+
+    if (it == parent->m_children.end() || it->second->m_is_leaf || !(radix_key_traits<K>::at(it->first, 0) == radix_key_traits<K>::at(child->m_key, 0))) {
+        // 没有冲突, 整棵子树直接拼接
+        child->m_parent = parent;
+        parent->m_children[child->m_key] = child;
+        return;
+    }
+
+    RadixTreeNode<K, T>* node = it->second;
+    int len1 = radix_length(node->m_key);
+    int len2 = radix_length(child->m_key);
+    int count = radix_common_prefix(child->m_key, 0, node->m_key);
+
+    if (count < len1)
+        node = split(node, count);
+
+    if (count == len2) {
+        // child 的边标签已经完全匹配, 把它的子节点逐个并入 node
+        std::map<K, RadixTreeNode<K, T>*> children;
+        children.swap(child->m_children);
+        RadixTreeNode<K, T>::destroy(child);
+
+        for (it = children.begin(); it != children.end(); ++it) {
+            merge(node, it->second, moved);
+        }
+    } else {
+        child->m_key = radix_substr(child->m_key, count, len2 - count);
+        child->m_depth += count;
+        merge(node, child, moved);
+    }
+}
+
+template <typename K, typename T>
+template <typename Range>
+typename RadixTree<K, T>::size_type RadixTree<K, T>::insert_batch(const Range& range, bool sorted) {
+    using input_iterator = decltype(std::begin(range));
+
+    std::vector<input_iterator> order;
+    for (input_iterator in = std::begin(range); in != std::end(range); ++in) {
+        order.push_back(in);
+    }
+    if (!sorted) {
+        // 稳定排序, 重复的 key 中排在前面的先插入
+        std::stable_sort(order.begin(), order.end(), [](const input_iterator& a, const input_iterator& b) {
+            return a->first < b->first;
+        });
+    }
+
+    if (m_root == NULL && !order.empty()) {
+        m_root = new RadixTreeNode<K, T>;
+        m_root->m_key = radix_substr(order[0]->first, 0, 0);
+    }
+
+    size_type count = 0;
+    RadixTreeNode<K, T>* leaf = NULL;
+    const K* last = NULL;
+
+    for (size_t i = 0; i < order.size(); i++) {
+        value_type val(order[i]->first, order[i]->second);
+        RadixTreeNode<K, T>* node = m_root;
+        int depth = 0;
+
+        RADIX_TREE_COUNT(inserts);
+
+        if (leaf != NULL) {
+            // 与上一个 key 的公共前缀长度
+            int lcp = radix_common_prefix(val.first, 0, *last);
+
+            // 从上一个叶子往上找到第一个路径完全落在公共前缀内的祖先, 从它开始查找
+            node = leaf->m_parent;
+            while (node != m_root && node->m_depth + radix_length(node->m_key) > lcp) {
+                node = node->m_parent;
+            }
+            depth = node->m_depth + radix_length(node->m_key);
+        }
+
+        std::pair<iterator, bool> ret = insert_at(find_node(val.first, node, depth), val);
+        if (ret.second)
+            count++;
+
+        leaf = ret.first.m_pointee;
+        last = &leaf->m_value->first;
+    }
+
+    return count;
+}
+
+template <typename K, typename T>
+template <typename Range>
+void RadixTree<K, T>::parallel_build(const Range& range, unsigned threads) {
+    using input_iterator = decltype(std::begin(range));
+    using shard_map = std::map<K, std::vector<input_iterator>>;
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    size_type total = std::distance(std::begin(range), std::end(range));
+    shard_map shards;
+
+    // 按前 width 个元素分片; 如果最大的分片仍然远大于平均值 (key 有很长的公共前缀), 加宽前缀重新分片
+    for (int width = 1; width <= 16; width *= 2) {
+        shard_map parts;
+        size_type largest = 0;
+
+        for (input_iterator in = std::begin(range); in != std::end(range); ++in) {
+            const K& key = in->first;
+            int len = radix_length(key);
+            std::vector<input_iterator>& part = parts[radix_substr(key, 0, len < width ? len : width)];
+            part.push_back(in);
+            if (part.size() > largest)
+                largest = part.size();
+        }
+
+        bool wider = parts.size() > shards.size();
+        shards.swap(parts);
+        if (threads == 1 || !wider || largest <= 2 * (total / threads + 1))
+            break;
+    }
+
+    std::vector<typename shard_map::iterator> jobs;
+    for (typename shard_map::iterator it = shards.begin(); it != shards.end(); ++it) {
+        jobs.push_back(it);
+    }
+
+    std::vector<RadixTree> parts(jobs.size());
+    std::vector<std::exception_ptr> errors(jobs.size());
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next.fetch_add(1)) < jobs.size()) {
+            try {
+                std::vector<input_iterator>& part = jobs[i]->second;
+                for (size_t j = 0; j < part.size(); j++) {
+                    parts[i].insert(value_type(part[j]->first, part[j]->second));
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads && i < jobs.size(); i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (size_t i = 0; i < pool.size(); i++) {
+        pool[i].join();
+    }
+
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+    }
+
+    // 分片按前缀有序, 互不相交的子树直接拼接到根节点下.
+    // 每次 merge() 都会重建过滤器, 所以先把过滤器摘下来, 全部拼接完之后只重建一次
+    RadixBloomFilter* filter = m_filter;
+    m_filter = NULL;
+    for (size_t i = 0; i < parts.size(); i++) {
+        merge(std::move(parts[i]));
+    }
+    if (filter != NULL) {
+        m_filter = filter;
+        rebuild_filter();
+    }
+}
+
+template <typename K, typename T>
+template <typename Function>
+void RadixTree<K, T>::parallel_for_each(Function fn, unsigned threads) {
+    if (m_root == NULL)
+        return;
+
+    auto visit = [&fn](unsigned, value_type& val) {
+        fn(val);
+    };
+
+    parallel_walk(m_root, threads, visit);
+}
+
+template <typename K, typename T>
+template <typename Map, typename Combine>
+std::decay_t<std::invoke_result_t<Map&, std::pair<const K, T>&>> RadixTree<K, T>::parallel_reduce(const K& prefix, Map map, Combine combine, unsigned threads) {
+    using result_type = std::decay_t<std::invoke_result_t<Map&, value_type&>>;
+
+    RadixTreeNode<K, T>* node = prefix_node(prefix);
+
+    if (node == NULL)
+        return result_type();
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    // 每个线程先在本地归约, 最后再合并各线程的结果
+    std::vector<std::optional<result_type>> partial(threads);
+
+    auto visit = [&](unsigned id, value_type& val) {
+        if (partial[id])
+            partial[id] = combine(std::move(*partial[id]), map(val));
+        else
+            partial[id] = map(val);
+    };
+
+    parallel_walk(node, threads, visit);
+
+    std::optional<result_type> result;
+    for (unsigned i = 0; i < threads; i++) {
+        if (!partial[i])
+            continue;
+        if (result)
+            result = combine(std::move(*result), std::move(*partial[i]));
+        else
+            result = std::move(partial[i]);
+    }
+
+    return result ? std::move(*result) : result_type();
+}
+
+// 以子树为任务的工作窃取遍历: 每个线程优先从自己队列的尾部取任务,
+// 空闲时从其他线程队列的头部窃取; 遇到扇出较大的节点且本地队列为空时, 把子节点拆成新任务
+template <typename K, typename T>
+template <typename Visit>
+void RadixTree<K, T>::parallel_walk(RadixTreeNode<K, T>* node, unsigned threads, Visit& visit) {
+    struct task_queue {
+        std::mutex lock;
+        std::deque<RadixTreeNode<K, T>*> tasks;
+    };
+
+    const size_t split_fanout = 4;
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    std::vector<task_queue> queues(threads);
+    std::atomic<size_t> pending(1);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    queues[0].tasks.push_back(node);
+
+    auto take = [&](unsigned id) -> RadixTreeNode<K, T>* {
+        for (unsigned i = 0; i < threads; i++) {
+            task_queue& queue = queues[(id + i) % threads];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.tasks.empty())
+                continue;
+            RadixTreeNode<K, T>* task;
+            if (i == 0) {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            } else {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            return task;
+        }
+        return NULL;
+    };
+
+    auto worker = [&](unsigned id) {
+        task_queue& own = queues[id];
+        std::vector<RadixTreeNode<K, T>*> stack;
+
+        while (pending.load() != 0) {
+            RadixTreeNode<K, T>* task = take(id);
+            if (task == NULL) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            try {
+                stack.push_back(task);
+                while (!stack.empty() && !failed.load(std::memory_order_relaxed)) {
+                    RadixTreeNode<K, T>* curr = stack.back();
+                    stack.pop_back();
+
+                    if (curr->m_is_leaf) {
+                        visit(id, *curr->m_value);
+                        continue;
+                    }
+
+                    bool share = false;
+                    if (threads > 1 && curr->m_children.size() >= split_fanout) {
+                        std::lock_guard<std::mutex> guard(own.lock);
+                        share = own.tasks.empty();
+                    }
+
+                    typename RadixTreeNode<K, T>::it_child it;
+                    if (share) {
+                        std::lock_guard<std::mutex> guard(own.lock);
+                        for (it = curr->m_children.begin(); it != curr->m_children.end(); ++it) {
+                            own.tasks.push_back(it->second);
+                        }
+                        pending.fetch_add(curr->m_children.size());
+                    } else {
+                        // 逆序入栈, 保证同一任务内按 key 的顺序访问
+                        typename std::map<K, RadixTreeNode<K, T>*>::reverse_iterator rit;
+                        for (rit = curr->m_children.rbegin(); rit != curr->m_children.rend(); ++rit) {
+                            stack.push_back(rit->second);
+                        }
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error)
+                    error = std::current_exception();
+                failed.store(true);
+            }
+
+            stack.clear();
+            pending.fetch_sub(1);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (size_t i = 0; i < pool.size(); i++) {
+        pool[i].join();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+template <typename K, typename T>
+void RadixTree<K, T>::glob_match(const K& pattern, std::vector<iterator>& vec)
+    requires std::integral<typename radix_key_traits<K>::element_type>
+{
+    vec.clear();
+
+    if (m_root == NULL)
+        return;
+
+    std::vector<glob_token> tokens = glob_compile(pattern);
+
+    // NFA 的状态是模式中的位置, * 可以不消耗元素直接进入下一个位置
+    std::vector<char> states(tokens.size() + 1, 0);
+    size_t i = 0;
+    states[0] = 1;
+    while (i < tokens.size() && tokens[i].kind == glob_token::star) {
+        states[++i] = 1;
+    }
+
+    glob_match(m_root, tokens, states, vec);
+}
+
+template <typename K, typename T>
+std::vector<typename RadixTree<K, T>::glob_token> RadixTree<K, T>::glob_compile(const K& pattern) {
+    std::vector<glob_token> tokens;
+    int len = radix_length(pattern);
+    const element_type star = '*', any = '?', escape = '\\', open = '[', close = ']', dash = '-';
+
+    for (int i = 0; i < len; i++) {
+        glob_token token;
+        token.kind = glob_token::literal;
+        token.elem = radix_at(pattern, i);
+        token.negate = false;
+
+        if (token.elem == star) {
+            // 连续的 * 等价于一个
+            if (!tokens.empty() && tokens.back().kind == glob_token::star)
+                continue;
+            token.kind = glob_token::star;
+        } else if (token.elem == any) {
+            token.kind = glob_token::any;
+        } else if (token.elem == escape && i + 1 < len) {
+            token.elem = radix_at(pattern, ++i);
+        } else if (token.elem == open) {
+            int j = i + 1;
+            if (j < len && (radix_at(pattern, j) == element_type('!') || radix_at(pattern, j) == element_type('^'))) {
+                token.negate = true;
+                j++;
+            }
+            // 紧跟在 [ 后面的 ] 是普通字符
+            int first = j;
+            while (j < len && (radix_at(pattern, j) != close || j == first)) {
+                element_type lo = radix_at(pattern, j);
+                if (lo == escape && j + 1 < len)
+                    lo = radix_at(pattern, ++j);
+                element_type hi = lo;
+                if (j + 2 < len && radix_at(pattern, j + 1) == dash && radix_at(pattern, j + 2) != close) {
+                    hi = radix_at(pattern, j + 2);
+                    j += 2;
+                }
+                token.ranges.push_back(std::make_pair(lo, hi));
+                j++;
+            }
+            if (j < len) {
+                token.kind = glob_token::range;
+                i = j;
+            } else {
+                // 没有闭合的 [ 当作普通字符
+                token.ranges.clear();
+                token.negate = false;
+            }
+        }
+
+        if (token.kind == glob_token::literal)
+            token.key = radix_substr(pattern, i, 1);
+
+        tokens.push_back(token);
+    }
+
+    return tokens;
+}
+
+// 读入一个元素, 从状态集合 from 转移到 to, 返回 to 是否非空
+template <typename K, typename T>
+bool RadixTree<K, T>::glob_step(const std::vector<glob_token>& tokens, const std::vector<char>& from, element_type elem, std::vector<char>& to) {
+    size_t n = tokens.size();
+    bool alive = false;
+
+    to.assign(n + 1, 0);
+
+    for (size_t i = 0; i < n; i++) {
+        if (!from[i])
+            continue;
+
+        const glob_token& token = tokens[i];
+        size_t next = i + 1;
+
+        switch (token.kind) {
+        case glob_token::literal:
+            if (!(token.elem == elem))
+                continue;
+            break;
+        case glob_token::any:
+            break;
+        case glob_token::star:
+            next = i;
+            break;
+        case glob_token::range: {
+            bool hit = false;
+            for (size_t r = 0; r < token.ranges.size() && !hit; r++) {
+                hit = !(elem < token.ranges[r].first) && !(token.ranges[r].second < elem);
+            }
+            if (hit == token.negate)
+                continue;
+            break;
+        }
+        }
+
+        to[next] = 1;
+        alive = true;
+        while (next < n && tokens[next].kind == glob_token::star) {
+            to[++next] = 1;
+        }
+    }
+
+    return alive;
+}
+
+template <typename K, typename T>
+void RadixTree<K, T>::glob_match(RadixTreeNode<K, T>* node, const std::vector<glob_token>& tokens, const std::vector<char>& states, std::vector<iterator>& vec) {
+    size_t n = tokens.size();
+
+    // 只剩结尾的 *, 整棵子树都匹配
+    if (n > 0 && states[n - 1] && tokens[n - 1].kind == glob_token::star) {
+        greedy_match(node, vec);
+        return;
+    }
+
+    typename RadixTreeNode<K, T>::it_child it = node->m_children.begin();
+    typename RadixTreeNode<K, T>::it_child last = node->m_children.end();
+
+    // 唯一的活动状态是普通字符时, 只有一个子节点可能匹配, 直接定位过去
+    size_t active = 0, pos = 0;
+    for (size_t i = 0; i <= n; i++) {
+        if (states[i]) {
+            active++;
+            pos = i;
+        }
+    }
+    if (active == 1 && pos < n && tokens[pos].kind == glob_token::literal) {
+        it = node->m_children.lower_bound(tokens[pos].key);
+        if (it == last || it->second->m_is_leaf || !(radix_at(it->first, 0) == tokens[pos].elem))
+            return;
+        last = it;
+        ++last;
+    }
+
+    std::vector<char> curr, next;
+
+    for (; it != last; ++it) {
+        RadixTreeNode<K, T>* child = it->second;
+
+        if (child->m_is_leaf) {
+            if (states[n])
+                vec.push_back(iterator(child));
+            continue;
+        }
+
+        curr = states;
+        bool alive = true;
+        int len = radix_length(child->m_key);
+        for (int i = 0; i < len && alive; i++) {
+            alive = glob_step(tokens, curr, radix_at(child->m_key, i), next);
+            curr.swap(next);
+        }
+
+        if (alive)
+            glob_match(child, tokens, curr, vec);
+    }
+}
+
+template <typename K, typename T>
+RadixTreeStats RadixTree<K, T>::stats() const {
+    RadixTreeStats result;
+
+    result.keys = m_size;
+    result.counters = m_counters.load();
+
+    if (m_root == NULL)
+        return result;
+
+    // libstdc++ 的红黑树节点: 颜色 + 三个指针, 之后是 pair<const K, Node*>
+    const size_t map_node = 4 * sizeof(void*) + sizeof(std::pair<const K, RadixTreeNode<K, T>*>);
+
+    std::vector<std::pair<const RadixTreeNode<K, T>*, size_t>> stack;
+    stack.push_back(std::make_pair(m_root, 0));
+
+    while (!stack.empty()) {
+        const RadixTreeNode<K, T>* node = stack.back().first;
+        size_t level = stack.back().second;
+        stack.pop_back();
+
+        result.nodes++;
+        result.node_bytes += sizeof(RadixTreeNode<K, T>);
+
+        if (node->m_value != NULL)
+            result.value_bytes += sizeof(value_type) + radix_heap_bytes(node->m_value->first);
+
+        if (node != m_root) {
+            result.label_bytes += 2 * radix_heap_bytes(node->m_key);
+            result.map_bytes += map_node;
+        }
+
+        if (node->m_is_leaf) {
+            result.leaves++;
+            result.depth[level]++;
+            continue;
+        }
+
+        result.internal++;
+        result.fanout[node->m_children.size()]++;
+        if (node != m_root)
+            result.label_length[radix_length(node->m_key)]++;
+
+        typename std::map<K, RadixTreeNode<K, T>*>::const_iterator it;
+        for (it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+            stack.push_back(std::make_pair(it->second, level + 1));
+        }
+    }
+
+    result.total_bytes = sizeof(*this) + result.node_bytes + result.label_bytes + result.map_bytes + result.value_bytes;
+    if (result.keys != 0)
+        result.bytes_per_key = static_cast<double>(result.total_bytes) / result.keys;
+
+    return result;
+}
+
+template <typename K, typename T>
+bool RadixTree<K, T>::compact(size_t max_nodes) {
+    if (m_root == NULL)
+        return true;
+
+    if (!m_compacting) {
+        // 新的一代: 按当前节点个数申请一整块内存, 旧内存块等全部节点搬完后再释放
+        size_t count = 0;
+        std::vector<RadixTreeNode<K, T>*> stack(1, m_root);
+        while (!stack.empty()) {
+            RadixTreeNode<K, T>* node = stack.back();
+            stack.pop_back();
+            count++;
+            typename RadixTreeNode<K, T>::it_child it;
+            for (it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+                stack.push_back(it->second);
+            }
+        }
+
+        m_retired.insert(m_retired.end(), m_arena.begin(), m_arena.end());
+        m_arena.clear();
+        m_arena_next = m_arena_end = NULL;
+
+        // 代号全局唯一, merge() 拼接过来的节点不会被误认为已经搬过
+        static std::atomic<unsigned> generations(0);
+        do {
+            m_generation = generations.fetch_add(1) + 1;
+        } while (m_generation == 0);
+
+        relocate(NULL, count);
+        m_compact_next = m_root;
+        m_compacting = true;
+    }
+
+    // 先序遍历: 父节点之后紧跟着它的整棵子树. 重新扫描时经过的已搬节点不计数
+    for (size_t moved = 0; m_compact_next != NULL && (max_nodes == 0 || moved < max_nodes);) {
+        RadixTreeNode<K, T>* node = relocate(m_compact_next, 64);
+        if (node != m_compact_next)
+            moved++;
+
+        if (!node->m_children.empty()) {
+            m_compact_next = node->m_children.begin()->second;
+            continue;
+        }
+
+        m_compact_next = NULL;
+        while (node->m_parent != NULL) {
+            typename RadixTreeNode<K, T>::it_child it = node->m_parent->m_children.find(node->m_key);
+            ++it;
+            if (it != node->m_parent->m_children.end()) {
+                m_compact_next = it->second;
+                break;
+            }
+            node = node->m_parent;
+        }
+    }
+
+    if (m_compact_next != NULL)
+        return false;
+
+    release(m_retired);
+    m_compacting = false;
+    return true;
+}
+
+// 把 node 搬到当前这一代的内存中并返回新地址; 内存不够时按 reserve 个节点申请新的内存块.
+// node 为 NULL 时只申请内存块
+template <typename K, typename T>
+RadixTreeNode<K, T>* RadixTree<K, T>::relocate(RadixTreeNode<K, T>* node, size_t reserve) {
+    if (node != NULL && node->m_arena == m_generation)
+        return node;
+
+    if (m_arena_next == m_arena_end) {
+        size_t bytes = (reserve == 0 ? 1 : reserve) * sizeof(RadixTreeNode<K, T>);
+        m_arena_next = static_cast<char*>(::operator new(bytes));
+        m_arena_end = m_arena_next + bytes;
+        m_arena.push_back(m_arena_next);
+    }
+
+    if (node == NULL)
+        return NULL;
+
+    RadixTreeNode<K, T>* copy = new (m_arena_next) RadixTreeNode<K, T>;
+    m_arena_next += sizeof(RadixTreeNode<K, T>);
+
+    copy->m_arena = m_generation;
+    copy->m_children.swap(node->m_children);
+    copy->m_parent = node->m_parent;
+    copy->m_value = node->m_value;
+    copy->m_depth = node->m_depth;
+    copy->m_is_leaf = node->m_is_leaf;
+    copy->m_key = node->m_key;
+    node->m_value = NULL;
+
+    typename RadixTreeNode<K, T>::it_child it;
+    for (it = copy->m_children.begin(); it != copy->m_children.end(); ++it) {
+        it->second->m_parent = copy;
+    }
+
+    if (copy->m_parent == NULL)
+        m_root = copy;
+    else
+        copy->m_parent->m_children.find(copy->m_key)->second = copy;
+
+    RadixTreeNode<K, T>::destroy(node);
+
+    return copy;
+}
+
+template <typename K, typename T>
+void RadixTree<K, T>::release(std::vector<void*>& chunks) {
+    for (size_t i = 0; i < chunks.size(); i++) {
+        ::operator delete(chunks[i]);
+    }
+    chunks.clear();
+}
+
+template <typename K, typename T>
+void RadixTree<K, T>::enable_filter(double fp_rate) {
+    m_filter_rate = fp_rate;
+    rebuild_filter();
+}
+
+template <typename K, typename T>
+void RadixTree<K, T>::disable_filter() {
+    delete m_filter;
+    m_filter = NULL;
+    m_filter_stale = 0;
+}
+
+// 按当前元素个数的两倍重新确定容量, 把所有 key 重新加入
+template <typename K, typename T>
+void RadixTree<K, T>::rebuild_filter() {
+    RadixBloomFilter* filter = new RadixBloomFilter(2 * m_size, m_filter_rate);
+
+    if (m_root != NULL) {
+        std::vector<RadixTreeNode<K, T>*> stack(1, m_root);
+        while (!stack.empty()) {
+            RadixTreeNode<K, T>* node = stack.back();
+            stack.pop_back();
+
+            if (node->m_is_leaf) {
+                filter->add(radix_hash(node->m_value->first));
+                continue;
+            }
+
+            typename RadixTreeNode<K, T>::it_child it;
+            for (it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+                stack.push_back(it->second);
+            }
+        }
+    }
+
+    delete m_filter;
+    m_filter = filter;
+    m_filter_stale = 0;
+    m_filter_stats.rebuilds.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename K, typename T>
+template <typename Callback>
+void RadixTree<K, T>::diff(const RadixTree& a, const RadixTree& b, Callback cb) {
+    if (a.m_root != NULL && b.m_root != NULL) {
+        diff(a.m_root, b.m_root, cb);
+        return;
+    }
+
+    // 至少一边为空, 另一边全部是新增或删除
+    std::vector<const value_type*> vec;
+    if (a.m_root != NULL)
+        leaves(a.m_root, vec);
+    for (size_t i = 0; i < vec.size(); i++) {
+        cb(RadixDiffKind::removed, vec[i]->first, &vec[i]->second, static_cast<const T*>(NULL));
+    }
+
+    vec.clear();
+    if (b.m_root != NULL)
+        leaves(b.m_root, vec);
+    for (size_t i = 0; i < vec.size(); i++) {
+        cb(RadixDiffKind::added, vec[i]->first, static_cast<const T*>(NULL), &vec[i]->second);
+    }
+}
+
+// a 和 b 对应同一个前缀
+template <typename K, typename T>
+template <typename Callback>
+void RadixTree<K, T>::diff(const RadixTreeNode<K, T>* a, const RadixTreeNode<K, T>* b, Callback& cb) {
+    // 只在 diff(t, t) 时成立
+    if (a == b)
+        return;
+
+    if (a->m_is_leaf && b->m_is_leaf) {
+        if (!(a->m_value->second == b->m_value->second))
+            cb(RadixDiffKind::changed, a->m_value->first, &a->m_value->second, &b->m_value->second);
+        return;
+    }
+
+    typename std::map<K, RadixTreeNode<K, T>*>::const_iterator it_a = a->m_children.begin();
+    typename std::map<K, RadixTreeNode<K, T>*>::const_iterator it_b = b->m_children.begin();
+    std::vector<const value_type*> vec_a, vec_b;
+
+    // 同一个节点的子节点按边标签排序, 除叶子的空标签外首元素互不相同, 所以可以按首元素归并
+    while (it_a != a->m_children.end() || it_b != b->m_children.end()) {
+        int order;
+        if (it_b == b->m_children.end())
+            order = -1;
+        else if (it_a == a->m_children.end())
+            order = 1;
+        else if (it_a->first == it_b->first)
+            order = 0;
+        else if (radix_length(it_a->first) == 0)
+            order = -1;
+        else if (radix_length(it_b->first) == 0)
+            order = 1;
+        else if (radix_key_traits<K>::at(it_a->first, 0) < radix_key_traits<K>::at(it_b->first, 0))
+            order = -1;
+        else if (radix_key_traits<K>::at(it_b->first, 0) < radix_key_traits<K>::at(it_a->first, 0))
+            order = 1;
+        else
+            order = 2;
+
+        if (order == 0) {
+            diff(it_a->second, it_b->second, cb);
+            ++it_a;
+            ++it_b;
+            continue;
+        }
+
+        vec_a.clear();
+        vec_b.clear();
+        if (order <= 0 || order == 2)
+            leaves((it_a++)->second, vec_a);
+        if (order >= 1)
+            leaves((it_b++)->second, vec_b);
+
+        // 两边的叶子都已按 key 排序, 归并比较
+        size_t i = 0, j = 0;
+        while (i < vec_a.size() || j < vec_b.size()) {
+            if (j == vec_b.size() || (i < vec_a.size() && vec_a[i]->first < vec_b[j]->first)) {
+                cb(RadixDiffKind::removed, vec_a[i]->first, &vec_a[i]->second, static_cast<const T*>(NULL));
+                i++;
+            } else if (i == vec_a.size() || vec_b[j]->first < vec_a[i]->first) {
+                cb(RadixDiffKind::added, vec_b[j]->first, static_cast<const T*>(NULL), &vec_b[j]->second);
+                j++;
+            } else {
+                if (!(vec_a[i]->second == vec_b[j]->second))
+                    cb(RadixDiffKind::changed, vec_a[i]->first, &vec_a[i]->second, &vec_b[j]->second);
+                i++;
+                j++;
+            }
+        }
+    }
+}
+
+// 按 key 的顺序收集 node 下的所有元素
+template <typename K, typename T>
+void RadixTree<K, T>::leaves(const RadixTreeNode<K, T>* node, std::vector<const value_type*>& vec) {
+    if (node->m_is_leaf) {
+        vec.push_back(node->m_value);
+        return;
+    }
+
+    typename std::map<K, RadixTreeNode<K, T>*>::const_iterator it;
+    for (it = node->m_children.begin(); it != node->m_children.end(); ++it) {
+        leaves(it->second, vec);
+    }
+}
+
 #endif // RADIX_TREE_HPP
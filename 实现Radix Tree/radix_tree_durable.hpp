@@ -0,0 +1,620 @@
+#ifndef RADIX_TREE_DURABLE_HPP
+#define RADIX_TREE_DURABLE_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "radix_tree.hpp"
+
+// 把 key / value 追加到 out 中
+template <typename K>
+void radix_serialize(std::string& out, const K& key) {
+    static_assert(std::is_trivially_copyable<K>::value, "radix_serialize needs a specialization for this type");
+    out.append(reinterpret_cast<const char*>(&key), sizeof(K));
+}
+
+// 从 [pos, end) 中读出一个对象并前移 pos, 数据不完整时返回 false
+template <typename K>
+bool radix_deserialize(const char*& pos, const char* end, K& key) {
+    static_assert(std::is_trivially_copyable<K>::value, "radix_deserialize needs a specialization for this type");
+    if (end - pos < static_cast<std::ptrdiff_t>(sizeof(K)))
+        return false;
+    std::memcpy(&key, pos, sizeof(K));
+    pos += sizeof(K);
+    return true;
+}
+
+template <>
+inline void radix_serialize<std::string>(std::string& out, const std::string& key) {
+    uint32_t len = key.size();
+    radix_serialize(out, len);
+    out.append(key);
+}
+
+template <>
+inline bool radix_deserialize<std::string>(const char*& pos, const char* end, std::string& key) {
+    uint32_t len;
+    if (!radix_deserialize(pos, end, len) || end - pos < static_cast<std::ptrdiff_t>(len))
+        return false;
+    key.assign(pos, len);
+    pos += len;
+    return true;
+}
+
+struct DurableOptions {
+    // insert / erase 是否等到日志落盘后才返回
+    bool sync = true;
+    // 组提交: 攒够这么多字节或者等待超过 commit_interval 就落盘一次
+    size_t commit_bytes = 1 << 20;
+    std::chrono::milliseconds commit_interval{2};
+    // 后台快照的周期, 0 表示只在调用 snapshot() 时生成快照
+    std::chrono::seconds snapshot_interval{300};
+};
+
+// 带预写日志 (WAL) 和周期快照的 RadixTree.
+// 目录中保存 snapshot 和 wal.<N> 两类文件: snapshot 记录了生成它时的日志代号 G,
+// 它包含了 wal.<G> 之前所有日志的效果. 重启时先加载 snapshot, 再按顺序重放 wal.<G>, wal.<G+1> ...
+// 写操作之间互斥; find / tree() 只能和写操作在同一个线程中使用
+template <typename K, typename T>
+class DurableRadixTree {
+public:
+    using key_type = K;
+    using mapped_type = T;
+    using value_type = std::pair<const K, T>;
+    using iterator = RadixTreeIterator<K, T>;
+    using size_type = std::size_t;
+
+    explicit DurableRadixTree(const std::string& dir, const DurableOptions& options = DurableOptions());
+    ~DurableRadixTree();
+
+    size_type size() const {
+        return m_tree.size();
+    }
+    bool empty() const {
+        return m_tree.empty();
+    }
+    iterator find(const K& key) {
+        return m_tree.find(key);
+    }
+    iterator end() {
+        return m_tree.end();
+    }
+    // 只读访问底层的树, 通过它做的修改不会写入日志
+    RadixTree<K, T>& tree() {
+        return m_tree;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& val);
+    bool erase(const K& key);
+
+    // 等待已经提交的日志全部落盘
+    void sync();
+    // 立即生成一次快照并删除不再需要的日志
+    void snapshot();
+
+private:
+    enum record_type : uint8_t {
+        record_insert = 1,
+        record_erase = 2,
+    };
+
+    std::string m_dir;
+    DurableOptions m_options;
+    RadixTree<K, T> m_tree;
+
+    // 保护 m_tree, 写操作和快照互斥
+    std::mutex m_tree_lock;
+
+    // 组提交状态, 由 m_log_lock 保护
+    std::mutex m_log_lock;
+    std::condition_variable m_log_cond;
+    std::condition_variable m_durable_cond;
+    std::string m_pending;
+    uint64_t m_appended;
+    uint64_t m_durable;
+    uint64_t m_generation;
+    int m_log_fd;
+    int m_error;
+    bool m_flushing;
+    bool m_stop;
+
+    std::mutex m_snapshot_lock;
+    std::condition_variable m_snapshot_cond;
+    // 串行化 snapshot(): 手动调用和后台线程不能同时写 snapshot.tmp 和删除日志
+    std::mutex m_snapshot_write_lock;
+
+    std::thread m_flusher;
+    std::thread m_snapshotter;
+
+    void recover();
+    bool replay(const std::string& path);
+    void open_log(uint64_t generation);
+    uint64_t append(record_type type, const K& key, const T* value);
+    void wait_durable(uint64_t seq);
+    void write_all(int fd, const std::string& data);
+    void sync_dir();
+    void flush_loop();
+    void snapshot_loop();
+    std::string path(const char* name, uint64_t generation) const;
+
+    static uint32_t checksum(const char* data, size_t len);
+    static void frame(std::string& out, const std::string& payload);
+    static bool unframe(const char*& pos, const char* end, const char*& payload, uint32_t& len);
+    static bool read_file(const std::string& path, std::string& data);
+
+    DurableRadixTree(const DurableRadixTree&);            // delete
+    DurableRadixTree& operator=(const DurableRadixTree&); // delete
+};
+
+template <typename K, typename T>
+DurableRadixTree<K, T>::DurableRadixTree(const std::string& dir, const DurableOptions& options)
+    : m_dir(dir), m_options(options), m_appended(0), m_durable(0), m_generation(0),
+      m_log_fd(-1), m_error(0), m_flushing(false), m_stop(false) {
+    if (::mkdir(m_dir.c_str(), 0755) != 0 && errno != EEXIST)
+        throw std::runtime_error("DurableRadixTree: cannot create " + m_dir);
+
+    recover();
+
+    m_flusher = std::thread(&DurableRadixTree::flush_loop, this);
+    if (m_options.snapshot_interval.count() > 0)
+        m_snapshotter = std::thread(&DurableRadixTree::snapshot_loop, this);
+}
+
+template <typename K, typename T>
+DurableRadixTree<K, T>::~DurableRadixTree() {
+    {
+        std::lock_guard<std::mutex> guard(m_snapshot_lock);
+        std::lock_guard<std::mutex> guard2(m_log_lock);
+        m_stop = true;
+    }
+    m_snapshot_cond.notify_all();
+    m_log_cond.notify_all();
+
+    if (m_snapshotter.joinable())
+        m_snapshotter.join();
+    m_flusher.join();
+
+    if (m_log_fd >= 0)
+        ::close(m_log_fd);
+}
+
+template <typename K, typename T>
+std::string DurableRadixTree<K, T>::path(const char* name, uint64_t generation) const {
+    return m_dir + "/" + name + "." + std::to_string(generation);
+}
+
+// FNV-1a, 用于识别写了一半的日志尾部
+template <typename K, typename T>
+uint32_t DurableRadixTree<K, T>::checksum(const char* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 记录格式: [长度 u32][校验和 u32][内容]
+template <typename K, typename T>
+void DurableRadixTree<K, T>::frame(std::string& out, const std::string& payload) {
+    radix_serialize(out, static_cast<uint32_t>(payload.size()));
+    radix_serialize(out, checksum(payload.data(), payload.size()));
+    out.append(payload);
+}
+
+template <typename K, typename T>
+bool DurableRadixTree<K, T>::unframe(const char*& pos, const char* end, const char*& payload, uint32_t& len) {
+    uint32_t sum;
+    const char* p = pos;
+
+    if (!radix_deserialize(p, end, len) || !radix_deserialize(p, end, sum))
+        return false;
+    if (end - p < static_cast<std::ptrdiff_t>(len) || checksum(p, len) != sum)
+        return false;
+
+    payload = p;
+    pos = p + len;
+    return true;
+}
+
+template <typename K, typename T>
+bool DurableRadixTree<K, T>::read_file(const std::string& path, std::string& data) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    char buf[1 << 16];
+    ssize_t n;
+    data.clear();
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0) {
+        data.append(buf, n);
+    }
+    ::close(fd);
+    return n == 0;
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::write_all(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("DurableRadixTree: write failed");
+        }
+        done += n;
+    }
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::recover() {
+    std::string data;
+    uint64_t generation = 0;
+
+    if (read_file(m_dir + "/snapshot", data)) {
+        const char* pos = data.data();
+        const char* end = pos + data.size();
+        const char* payload;
+        uint32_t len;
+        uint64_t count = 0;
+
+        // 快照头: [代号 u64][元素个数 u64], 之后每个元素是一条 insert 记录
+        if (!unframe(pos, end, payload, len) || !radix_deserialize(payload, payload + len, generation)
+            || !radix_deserialize(payload, payload + len, count))
+            throw std::runtime_error("DurableRadixTree: corrupt snapshot in " + m_dir);
+
+        for (uint64_t i = 0; i < count; i++) {
+            std::pair<K, T> val;
+            if (!unframe(pos, end, payload, len) || !radix_deserialize(payload, payload + len, val.first)
+                || !radix_deserialize(payload, payload + len, val.second))
+                throw std::runtime_error("DurableRadixTree: corrupt snapshot in " + m_dir);
+            m_tree.insert(val);
+        }
+    }
+
+    // 找出所有 wal.<N>, 删除已经被快照覆盖的, 按顺序重放其余的
+    std::vector<uint64_t> logs;
+    DIR* d = ::opendir(m_dir.c_str());
+    if (d != NULL) {
+        struct dirent* entry;
+        while ((entry = ::readdir(d)) != NULL) {
+            if (std::strncmp(entry->d_name, "wal.", 4) == 0)
+                logs.push_back(std::strtoull(entry->d_name + 4, NULL, 10));
+        }
+        ::closedir(d);
+    }
+    std::sort(logs.begin(), logs.end());
+
+    uint64_t last = generation;
+    for (size_t i = 0; i < logs.size(); i++) {
+        if (logs[i] < generation) {
+            ::unlink(path("wal", logs[i]).c_str());
+            continue;
+        }
+        // 日志尾部可能因为崩溃而不完整, 遇到第一条坏记录就停止
+        replay(path("wal", logs[i]));
+        last = logs[i] + 1;
+    }
+
+    // 从不往可能残缺的旧日志后面追加, 总是开始新的一代
+    open_log(last);
+}
+
+template <typename K, typename T>
+bool DurableRadixTree<K, T>::replay(const std::string& file) {
+    std::string data;
+    if (!read_file(file, data))
+        return false;
+
+    const char* pos = data.data();
+    const char* end = pos + data.size();
+    const char* payload;
+    uint32_t len;
+
+    while (unframe(pos, end, payload, len)) {
+        const char* p = payload;
+        const char* q = payload + len;
+        uint8_t type;
+        std::pair<K, T> val;
+
+        if (!radix_deserialize(p, q, type) || !radix_deserialize(p, q, val.first))
+            return false;
+
+        if (type == record_insert) {
+            if (!radix_deserialize(p, q, val.second))
+                return false;
+            m_tree.insert(val);
+        } else if (type == record_erase) {
+            m_tree.erase(val.first);
+        } else {
+            return false;
+        }
+    }
+
+    return pos == end;
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::open_log(uint64_t generation) {
+    std::string file = path("wal", generation);
+    int fd = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0)
+        throw std::runtime_error("DurableRadixTree: cannot open " + file);
+
+    // 新建的日志文件要在目录中落盘, 否则崩溃后整个文件 (连同已经 fdatasync 的记录) 可能丢失
+    try {
+        sync_dir();
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    if (m_log_fd >= 0)
+        ::close(m_log_fd);
+    m_log_fd = fd;
+    m_generation = generation;
+}
+
+template <typename K, typename T>
+std::pair<typename DurableRadixTree<K, T>::iterator, bool> DurableRadixTree<K, T>::insert(const value_type& val) {
+    std::pair<iterator, bool> ret;
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> guard(m_tree_lock);
+        ret = m_tree.insert(val);
+        if (ret.second) {
+            // 日志不可写时撤销修改, 保证内存中的树与日志一致
+            try {
+                seq = append(record_insert, val.first, &val.second);
+            } catch (...) {
+                m_tree.erase(val.first);
+                throw;
+            }
+        }
+    }
+
+    // 放开树锁之后再等待落盘, 让并发的写操作能合并到同一次提交中
+    if (seq != 0 && m_options.sync)
+        wait_durable(seq);
+
+    return ret;
+}
+
+template <typename K, typename T>
+bool DurableRadixTree<K, T>::erase(const K& key) {
+    bool erased;
+    uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> guard(m_tree_lock);
+        iterator it = m_tree.find(key);
+        erased = it != m_tree.end();
+        if (erased) {
+            // 先保存旧值, 日志不可写时放回去
+            value_type old(it->first, it->second);
+            m_tree.erase(key);
+            try {
+                seq = append(record_erase, key, NULL);
+            } catch (...) {
+                m_tree.insert(old);
+                throw;
+            }
+        }
+    }
+
+    if (seq != 0 && m_options.sync)
+        wait_durable(seq);
+
+    return erased;
+}
+
+template <typename K, typename T>
+uint64_t DurableRadixTree<K, T>::append(record_type type, const K& key, const T* value) {
+    std::string payload;
+    radix_serialize(payload, static_cast<uint8_t>(type));
+    radix_serialize(payload, key);
+    if (value != NULL)
+        radix_serialize(payload, *value);
+
+    std::lock_guard<std::mutex> guard(m_log_lock);
+    if (m_error != 0)
+        throw std::runtime_error("DurableRadixTree: log is not writable");
+
+    frame(m_pending, payload);
+    uint64_t seq = ++m_appended;
+
+    if (m_pending.size() >= m_options.commit_bytes)
+        m_log_cond.notify_one();
+
+    return seq;
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::wait_durable(uint64_t seq) {
+    std::unique_lock<std::mutex> guard(m_log_lock);
+    m_log_cond.notify_one();
+    m_durable_cond.wait(guard, [&] {
+        return m_durable >= seq || m_error != 0;
+    });
+
+    if (m_durable < seq)
+        throw std::runtime_error("DurableRadixTree: log is not writable");
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::sync() {
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> guard(m_log_lock);
+        seq = m_appended;
+    }
+    wait_durable(seq);
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::sync_dir() {
+    int dir = ::open(m_dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir < 0)
+        throw std::runtime_error("DurableRadixTree: cannot open " + m_dir);
+    int ok = ::fsync(dir);
+    ::close(dir);
+    if (ok != 0)
+        throw std::runtime_error("DurableRadixTree: cannot sync " + m_dir);
+}
+
+// 组提交线程: 每次把积累的所有记录一起写入并 fdatasync
+template <typename K, typename T>
+void DurableRadixTree<K, T>::flush_loop() {
+    std::unique_lock<std::mutex> guard(m_log_lock);
+
+    for (;;) {
+        m_log_cond.wait_for(guard, m_options.commit_interval, [&] {
+            return m_stop || m_pending.size() >= m_options.commit_bytes;
+        });
+
+        if (m_pending.empty()) {
+            if (m_stop)
+                break;
+            continue;
+        }
+
+        std::string batch;
+        batch.swap(m_pending);
+        uint64_t seq = m_appended;
+        int fd = m_log_fd;
+
+        // 写文件时不持有锁, 新的记录继续进入 m_pending; snapshot() 通过 m_flushing 等待这一批写完
+        m_flushing = true;
+        guard.unlock();
+
+        int error = 0;
+        try {
+            write_all(fd, batch);
+            if (::fdatasync(fd) != 0)
+                error = errno;
+        } catch (const std::runtime_error&) {
+            error = errno != 0 ? errno : EIO;
+        }
+
+        guard.lock();
+        m_flushing = false;
+        if (error != 0)
+            m_error = error;
+        else
+            m_durable = seq;
+        m_durable_cond.notify_all();
+    }
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::snapshot_loop() {
+    std::unique_lock<std::mutex> guard(m_snapshot_lock);
+
+    while (!m_snapshot_cond.wait_for(guard, m_options.snapshot_interval, [&] { return m_stop; })) {
+        guard.unlock();
+        try {
+            snapshot();
+        } catch (const std::runtime_error&) {
+            // 快照失败不影响日志, 下个周期再试
+        }
+        guard.lock();
+    }
+}
+
+template <typename K, typename T>
+void DurableRadixTree<K, T>::snapshot() {
+    std::lock_guard<std::mutex> snapshot_guard(m_snapshot_write_lock);
+
+    std::vector<std::pair<K, T>> elements;
+    std::string data;
+    uint64_t generation;
+    {
+        // 持有树锁: 保证快照内容与日志的切换点一致
+        std::lock_guard<std::mutex> tree_guard(m_tree_lock);
+        std::unique_lock<std::mutex> log_guard(m_log_lock);
+
+        // 先让旧日志中的记录全部落盘, 再切换到新一代日志
+        m_durable_cond.wait(log_guard, [&] {
+            return !m_flushing;
+        });
+        try {
+            write_all(m_log_fd, m_pending);
+            m_pending.clear();
+            if (::fdatasync(m_log_fd) != 0)
+                throw std::runtime_error("DurableRadixTree: fdatasync failed");
+        } catch (const std::runtime_error&) {
+            m_error = errno != 0 ? errno : EIO;
+            m_durable_cond.notify_all();
+            throw;
+        }
+        m_durable = m_appended;
+        m_durable_cond.notify_all();
+
+        open_log(m_generation + 1);
+        generation = m_generation;
+        log_guard.unlock();
+
+        // 持有树锁时只复制元素, 序列化和写文件都在放开树锁之后进行, 不阻塞写操作
+        elements.reserve(m_tree.size());
+        if (!m_tree.empty()) {
+            for (iterator it = m_tree.begin(); it != m_tree.end(); ++it) {
+                elements.push_back(std::pair<K, T>(it->first, it->second));
+            }
+        }
+    }
+
+    std::string header;
+    radix_serialize(header, generation);
+    radix_serialize(header, static_cast<uint64_t>(elements.size()));
+    frame(data, header);
+
+    for (size_t i = 0; i < elements.size(); i++) {
+        std::string payload;
+        radix_serialize(payload, elements[i].first);
+        radix_serialize(payload, elements[i].second);
+        frame(data, payload);
+    }
+    std::vector<std::pair<K, T>>().swap(elements);
+
+    std::string tmp = m_dir + "/snapshot.tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("DurableRadixTree: cannot open " + tmp);
+    try {
+        write_all(fd, data);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    int ok = ::fsync(fd);
+    ::close(fd);
+    if (ok != 0 || std::rename(tmp.c_str(), (m_dir + "/snapshot").c_str()) != 0)
+        throw std::runtime_error("DurableRadixTree: cannot write snapshot in " + m_dir);
+
+    // rename 本身也要落盘, 之后旧日志才可以删除
+    sync_dir();
+
+    for (uint64_t g = generation; g-- > 0;) {
+        if (::unlink(path("wal", g).c_str()) != 0)
+            break;
+    }
+}
+
+#endif // RADIX_TREE_DURABLE_HPP
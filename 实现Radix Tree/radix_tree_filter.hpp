@@ -0,0 +1,114 @@
+#ifndef RADIX_TREE_FILTER_HPP
+#define RADIX_TREE_FILTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "radix_key_traits.hpp"
+
+struct RadixFilterStats {
+    // 经过过滤器的 find() 次数
+    size_t lookups = 0;
+    // 被过滤器直接判定为不存在的次数
+    size_t negatives = 0;
+    // 过滤器判定可能存在, 但树中没有的次数
+    size_t false_positives = 0;
+    // 过滤器重建的次数
+    size_t rebuilds = 0;
+};
+
+// RadixTree 内部累计用的过滤器统计, 并发的 find() 用 relaxed 原子操作累加
+struct RadixFilterAtomicStats {
+    std::atomic<size_t> lookups{0};
+    std::atomic<size_t> negatives{0};
+    std::atomic<size_t> false_positives{0};
+    std::atomic<size_t> rebuilds{0};
+
+    RadixFilterStats load() const {
+        RadixFilterStats result;
+        result.lookups = lookups.load(std::memory_order_relaxed);
+        result.negatives = negatives.load(std::memory_order_relaxed);
+        result.false_positives = false_positives.load(std::memory_order_relaxed);
+        result.rebuilds = rebuilds.load(std::memory_order_relaxed);
+        return result;
+    }
+};
+
+// 分块 Bloom 过滤器: 一个 key 的所有比特都落在同一个 64 字节的块中.
+// 块按 64 字节对齐 (C++17 的 vector 对过对齐类型使用对齐的 operator new), 每次查询只访问一条缓存行
+class RadixBloomFilter {
+public:
+    RadixBloomFilter(size_t capacity, double fp_rate)
+        : m_capacity(capacity < 64 ? 64 : capacity) {
+        if (fp_rate <= 0 || fp_rate >= 1)
+            fp_rate = 0.01;
+        // 标准 Bloom 过滤器需要 -n ln(p) / ln(2)^2 个比特, 分块之后多留 20% 补偿误判率
+        double bits = -1.2 * m_capacity * std::log(fp_rate) / (std::log(2.0) * std::log(2.0));
+        size_t blocks = static_cast<size_t>(bits / block_bits) + 1;
+        m_hashes = static_cast<unsigned>(std::lround(bits / m_capacity * std::log(2.0)));
+        if (m_hashes < 1)
+            m_hashes = 1;
+        if (m_hashes > 16)
+            m_hashes = 16;
+        m_blocks.assign(blocks, block_type());
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+    size_t bytes() const {
+        return m_blocks.size() * sizeof(block_type);
+    }
+
+    void add(uint64_t hash) {
+        uint64_t* block = locate(hash);
+        uint32_t h1 = static_cast<uint32_t>(hash);
+        uint32_t h2 = static_cast<uint32_t>((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+        for (unsigned i = 0; i < m_hashes; i++) {
+            uint32_t bit = (h1 + i * h2) % block_bits;
+            block[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+    }
+
+    bool may_contain(uint64_t hash) const {
+        const uint64_t* block = locate(hash);
+        uint32_t h1 = static_cast<uint32_t>(hash);
+        uint32_t h2 = static_cast<uint32_t>((hash * 0x9e3779b97f4a7c15ULL) >> 32) | 1;
+        for (unsigned i = 0; i < m_hashes; i++) {
+            uint32_t bit = (h1 + i * h2) % block_bits;
+            if ((block[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    void clear() {
+        std::fill(m_blocks.begin(), m_blocks.end(), block_type());
+    }
+
+private:
+    static const size_t block_words = 8;
+    static const uint32_t block_bits = block_words * 64;
+
+    struct alignas(64) block_type {
+        uint64_t words[block_words] = {};
+    };
+
+    size_t m_capacity;
+    unsigned m_hashes;
+    std::vector<block_type> m_blocks;
+
+    // 用高 24 位选块, 块内的比特由低位和再次混合后的哈希决定
+    uint64_t* locate(uint64_t hash) {
+        return m_blocks[(hash >> 40) * m_blocks.size() >> 24].words;
+    }
+    const uint64_t* locate(uint64_t hash) const {
+        return m_blocks[(hash >> 40) * m_blocks.size() >> 24].words;
+    }
+};
+
+#endif // RADIX_TREE_FILTER_HPP
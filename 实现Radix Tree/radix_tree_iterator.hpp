@@ -12,6 +12,8 @@ class RadixTreeNode;
 template <typename K, typename T>
 class RadixTreeIterator {
     friend class RadixTree<K, T>;
+    template <typename U>
+    friend class TopicFilterIndex;
 
 public:
     RadixTreeIterator()
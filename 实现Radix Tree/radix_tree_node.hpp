@@ -7,6 +7,8 @@ template <typename K, typename T>
 class RadixTreeNode {
   friend class RadixTree<K, T>;
   friend class RadixTreeIterator<K, T>;
+  template <typename U>
+  friend class TopicFilterIndex;
 
   typedef std::pair<const K, T> value_type;
   typedef typename std::map<K, RadixTreeNode<K, T> *>::iterator it_child;
@@ -18,6 +20,7 @@ class RadixTreeNode {
         m_value(nullptr),
         m_depth(0),
         m_is_leaf(false),
+        m_arena(0),
         m_key() {}
   RadixTreeNode(const value_type &val);
   RadixTreeNode(const RadixTreeNode &);             // delete
@@ -25,11 +28,16 @@ class RadixTreeNode {
 
   ~RadixTreeNode();
 
+  // 释放节点及其子树; 由 RadixTree::compact() 放在连续内存中的节点只调用析构函数
+  static void destroy(RadixTreeNode *node);
+
   std::map<K, RadixTreeNode<K, T> *> m_children;
   RadixTreeNode<K, T> *m_parent;
   value_type *m_value;
   int m_depth;
   bool m_is_leaf;
+  // 所在的 compact() 内存代号, 0 表示单独 new 出来的节点
+  unsigned m_arena;
   K m_key;
 };
 
@@ -40,6 +48,7 @@ RadixTreeNode<K, T>::RadixTreeNode(const value_type &val) :
     m_value(nullptr),
     m_depth(0),
     m_is_leaf(false),
+    m_arena(0),
     m_key()
 {
     m_value = new value_type(val);
@@ -50,10 +59,21 @@ RadixTreeNode<K, T>::~RadixTreeNode()
 {
     it_child it;
     for (it = m_children.begin(); it != m_children.end(); ++it) {
-        delete it->second;
+        destroy(it->second);
     }
     delete m_value;
 }
+
+template <typename K, typename T>
+void RadixTreeNode<K, T>::destroy(RadixTreeNode *node)
+{
+    if (node == nullptr)
+        return;
+    if (node->m_arena != 0)
+        node->~RadixTreeNode();
+    else
+        delete node;
+}
       
 
 #endif // RadixTreeNode_HPP
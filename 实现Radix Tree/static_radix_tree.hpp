@@ -0,0 +1,197 @@
+#ifndef STATIC_RADIX_TREE_HPP
+#define STATIC_RADIX_TREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 可以作为非类型模板参数的字符串字面量 (C++20)
+template <std::size_t N>
+struct radix_literal {
+    char data[N]{};
+
+    constexpr radix_literal(const char (&str)[N]) {
+        std::copy_n(str, N, data);
+    }
+    constexpr std::string_view view() const {
+        return std::string_view(data, N - 1);
+    }
+};
+
+// 编译期构建的压缩前缀树, 用于匹配固定的关键字集合:
+//     using Method = StaticRadixTree<"GET", "POST", "PUT">;
+//     static_assert(Method::find("POST") == 1);
+// 所有节点在编译期排好放在一个静态数组里, 不需要堆内存, 也没有运行时初始化.
+// 每个节点的子节点连续存放并按首字符排序, 查找时按首字符二分选边, 再整段比较边标签
+template <radix_literal... Keys>
+class StaticRadixTree {
+public:
+    static constexpr std::size_t key_count = sizeof...(Keys);
+
+    // 返回 key 在模板参数中的下标, 不存在时返回 -1
+    static constexpr int find(std::string_view key) noexcept;
+    static constexpr bool contains(std::string_view key) noexcept {
+        return find(key) >= 0;
+    }
+    static constexpr std::string_view key(std::size_t index) noexcept {
+        return keys[index];
+    }
+
+    // 最长前缀匹配: 返回 text 中最长的、本身是关键字的前缀的下标, 没有则返回 -1
+    static constexpr int longest_match(std::string_view text) noexcept;
+
+private:
+    struct node {
+        // 边标签是 keys[source] 从 offset 开始的 length 个字符
+        uint32_t source;
+        uint32_t offset;
+        uint32_t length;
+        uint32_t first_child;
+        uint32_t child_count;
+        int value;
+        char first;
+    };
+
+    // 一个关键字最多贡献一个叶子和一个分叉节点, 再加上根节点
+    static constexpr std::size_t max_nodes = 2 * key_count + 1;
+
+    struct table_type {
+        std::array<node, max_nodes> nodes{};
+        std::size_t size = 0;
+    };
+
+    static constexpr std::array<std::string_view, key_count> keys = {Keys.view()...};
+    static constexpr table_type build();
+    static constexpr table_type table = build();
+
+    static constexpr const node* child(const node& parent, char c) noexcept;
+};
+
+template <radix_literal... Keys>
+constexpr typename StaticRadixTree<Keys...>::table_type StaticRadixTree<Keys...>::build() {
+    table_type result;
+
+    std::array<uint32_t, key_count> order{};
+    for (uint32_t i = 0; i < key_count; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) {
+        return keys[a] < keys[b];
+    });
+    for (std::size_t i = 1; i < key_count; i++) {
+        if (keys[order[i - 1]] == keys[order[i]])
+            throw "StaticRadixTree: duplicate key";
+    }
+
+    // 每个待展开的节点对应 order 中一段有序区间 [lo, hi), 这些关键字共享前 depth 个字符
+    struct pending {
+        uint32_t index;
+        uint32_t lo;
+        uint32_t hi;
+        uint32_t depth;
+    };
+    std::array<pending, max_nodes> queue{};
+    std::size_t head = 0, tail = 0;
+
+    result.nodes[0] = node{0, 0, 0, 0, 0, -1, '\0'};
+    result.size = 1;
+    queue[tail++] = pending{0, 0, static_cast<uint32_t>(key_count), 0};
+
+    // 广度优先展开, 保证同一节点的子节点在数组中连续
+    while (head < tail) {
+        pending curr = queue[head++];
+        node& parent = result.nodes[curr.index];
+        uint32_t lo = curr.lo;
+
+        // 恰好在这里结束的关键字排在最前面
+        if (lo < curr.hi && keys[order[lo]].size() == curr.depth) {
+            parent.value = order[lo];
+            lo++;
+        }
+
+        parent.first_child = result.size;
+
+        while (lo < curr.hi) {
+            std::string_view first = keys[order[lo]];
+            uint32_t hi = lo + 1;
+            while (hi < curr.hi && keys[order[hi]][curr.depth] == first[curr.depth]) {
+                hi++;
+            }
+
+            // 区间内的关键字已排序, 首尾两个的公共前缀就是整组的公共前缀
+            std::string_view last = keys[order[hi - 1]];
+            uint32_t end = curr.depth + 1;
+            while (end < first.size() && end < last.size() && first[end] == last[end]) {
+                end++;
+            }
+
+            uint32_t index = result.size++;
+            result.nodes[index] = node{order[lo], curr.depth, end - curr.depth, 0, 0, -1, first[curr.depth]};
+            queue[tail++] = pending{index, lo, hi, end};
+            lo = hi;
+        }
+
+        result.nodes[curr.index].child_count = result.size - result.nodes[curr.index].first_child;
+    }
+
+    return result;
+}
+
+template <radix_literal... Keys>
+constexpr const typename StaticRadixTree<Keys...>::node* StaticRadixTree<Keys...>::child(const node& parent, char c) noexcept {
+    const node* lo = table.nodes.data() + parent.first_child;
+    const node* hi = lo + parent.child_count;
+
+    while (lo < hi) {
+        const node* mid = lo + (hi - lo) / 2;
+        if (static_cast<unsigned char>(mid->first) < static_cast<unsigned char>(c))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == table.nodes.data() + parent.first_child + parent.child_count || lo->first != c)
+        return nullptr;
+    return lo;
+}
+
+template <radix_literal... Keys>
+constexpr int StaticRadixTree<Keys...>::find(std::string_view key) noexcept {
+    const node* curr = table.nodes.data();
+    std::size_t pos = 0;
+
+    while (pos < key.size()) {
+        curr = child(*curr, key[pos]);
+        if (curr == nullptr)
+            return -1;
+        if (key.substr(pos, curr->length) != keys[curr->source].substr(curr->offset, curr->length))
+            return -1;
+        pos += curr->length;
+    }
+
+    return curr->value;
+}
+
+template <radix_literal... Keys>
+constexpr int StaticRadixTree<Keys...>::longest_match(std::string_view text) noexcept {
+    const node* curr = table.nodes.data();
+    std::size_t pos = 0;
+    int best = curr->value;
+
+    while (pos < text.size()) {
+        curr = child(*curr, text[pos]);
+        if (curr == nullptr)
+            break;
+        if (text.substr(pos, curr->length) != keys[curr->source].substr(curr->offset, curr->length))
+            break;
+        pos += curr->length;
+        if (curr->value >= 0)
+            best = curr->value;
+    }
+
+    return best;
+}
+
+#endif // STATIC_RADIX_TREE_HPP
@@ -0,0 +1,163 @@
+#ifndef STRING_DICTIONARY_HPP
+#define STRING_DICTIONARY_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "radix_tree.hpp"
+
+// 字符串字典编码: 每个不同的字符串分配一个连续的 uint32_t 编号, 相同的字符串只存一份.
+// string → 编号 通过 RadixTree 查找, 编号 → string 通过一张扁平的偏移表查找.
+// freeze() 之后编号按字典序重新分配, 同一前缀的字符串对应一段连续的编号区间.
+// 读操作 (lookup/decode/prefix_range) 之间可以并发, 与 encode/freeze 互斥.
+// 并发读依赖 RadixTree::find 不修改树 (计数器和过滤器统计是原子的, 过滤器只在写操作中重建)
+class StringDictionary {
+public:
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    StringDictionary()
+        : m_offsets(1, 0), m_sorted(0) {
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_offsets.size() - 1;
+    }
+    // 字符串本身占用的字节数
+    size_t bytes() const {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_bytes.size();
+    }
+
+    // 返回 str 的编号, 不存在时分配一个新编号 (当前的元素个数)
+    uint32_t encode(const std::string& str);
+    // 返回 str 的编号, 不存在时返回 npos
+    uint32_t lookup(const std::string& str) const;
+    // 编号不存在时抛出 std::out_of_range
+    std::string decode(uint32_t id) const;
+
+    // 按字典序重新分配所有编号, 返回 旧编号 → 新编号 的映射, 用于改写已经编码的数据
+    std::vector<uint32_t> freeze();
+    // 以 prefix 为前缀的字符串的编号区间 [first, second).
+    // 只包含上一次 freeze() 时已有的字符串, 之后 encode 的新字符串编号不在有序区间内
+    std::pair<uint32_t, uint32_t> prefix_range(const std::string& prefix) const;
+
+private:
+    mutable std::shared_mutex m_mutex;
+    mutable RadixTree<std::string, uint32_t> m_tree;
+
+    // 编号为 i 的字符串是 m_bytes[m_offsets[i], m_offsets[i + 1])
+    std::string m_bytes;
+    std::vector<size_t> m_offsets;
+    // 编号小于 m_sorted 的字符串按字典序排列
+    uint32_t m_sorted;
+
+    std::string_view view(uint32_t id) const {
+        return std::string_view(m_bytes.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+    }
+};
+
+inline uint32_t StringDictionary::encode(const std::string& str) {
+    uint32_t id = lookup(str);
+    if (id != npos)
+        return id;
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    // 释放读锁之后可能已经被其他线程插入
+    std::pair<RadixTree<std::string, uint32_t>::iterator, bool> ret;
+    ret = m_tree.insert(std::pair<const std::string, uint32_t>(str, m_offsets.size() - 1));
+    if (!ret.second)
+        return ret.first->second;
+
+    if (m_offsets.size() - 1 >= npos) {
+        m_tree.erase(ret.first);
+        throw std::length_error("StringDictionary: too many strings");
+    }
+
+    m_bytes.append(str);
+    m_offsets.push_back(m_bytes.size());
+
+    return ret.first->second;
+}
+
+inline uint32_t StringDictionary::lookup(const std::string& str) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    RadixTree<std::string, uint32_t>::iterator it = m_tree.find(str);
+    if (it == m_tree.end())
+        return npos;
+    return it->second;
+}
+
+inline std::string StringDictionary::decode(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    if (id >= m_offsets.size() - 1)
+        throw std::out_of_range("StringDictionary: unknown id");
+    return std::string(view(id));
+}
+
+inline std::vector<uint32_t> StringDictionary::freeze() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    std::vector<uint32_t> remap(m_offsets.size() - 1);
+    std::string bytes;
+    std::vector<size_t> offsets(1, 0);
+    bytes.reserve(m_bytes.size());
+    offsets.reserve(m_offsets.size());
+
+    // 树的遍历顺序就是字典序
+    if (!m_tree.empty()) {
+        RadixTree<std::string, uint32_t>::iterator it;
+        for (it = m_tree.begin(); it != m_tree.end(); ++it) {
+            uint32_t id = offsets.size() - 1;
+            remap[it->second] = id;
+            it->second = id;
+            bytes.append(it->first);
+            offsets.push_back(bytes.size());
+        }
+    }
+
+    m_bytes.swap(bytes);
+    m_offsets.swap(offsets);
+    m_sorted = m_offsets.size() - 1;
+
+    return remap;
+}
+
+inline std::pair<uint32_t, uint32_t> StringDictionary::prefix_range(const std::string& prefix) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    // 有序区间内以 prefix 为前缀的字符串是连续的: 先找第一个不小于 prefix 的, 再找第一个前缀大于 prefix 的
+    uint32_t lo = 0, hi = m_sorted;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (view(mid) < prefix)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    uint32_t first = lo;
+    hi = m_sorted;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (view(mid).substr(0, prefix.size()) == prefix)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return std::pair<uint32_t, uint32_t>(first, lo);
+}
+
+#endif // STRING_DICTIONARY_HPP
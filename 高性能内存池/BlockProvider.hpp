@@ -0,0 +1,311 @@
+#ifndef BLOCK_PROVIDER_HPP
+#define BLOCK_PROVIDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// 内存池向系统申请内存区块的方式. 一个 BlockProvider 需要提供
+//     void* allocate(size_t size, size_t alignment);
+//     void deallocate(void* p, size_t size, size_t alignment) noexcept;
+// 并且可以复制 (复制得到的对象不共享已经申请的内存) 和移动
+
+// 默认的方式, 每个内存区块调用一次对齐的 operator new
+class NewBlockProvider {
+public:
+    void* allocate(size_t size, size_t alignment) {
+        return operator new(size, std::align_val_t(alignment));
+    }
+    void deallocate(void* p, size_t size, size_t alignment) noexcept {
+        operator delete(p, size, std::align_val_t(alignment));
+    }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+
+struct MmapBlockOptions {
+    // 每次 mmap 的大小, 内存区块从中依次切出; 必须是 2 的幂且是页大小的整数倍
+    size_t slabSize = size_t(2) << 20;
+    // 对映射的内存调用 madvise(MADV_HUGEPAGE), 由透明大页 (THP) 提供 2MB 的页
+    bool hugePages = true;
+    // 使用预留的大页 (MAP_HUGETLB), slabSize 必须是 2MB 的整数倍; 预留的大页不够时退回普通页
+    bool hugeTLB = false;
+    // 映射后立即触发缺页, 之后的分配不再有缺页中断 (相当于 MAP_POPULATE)
+    bool populate = false;
+    // 非负时用 mbind 让映射的内存优先从这个 NUMA 节点分配, 节点不存在或内存不足时按默认策略分配
+    int numaNode = -1;
+};
+
+// 用 mmap 申请大块内存 (slab), 按请求的大小和对齐切成内存区块, 大幅减少 TLB 项和系统调用的次数.
+// 超过 slabSize 一半的请求单独映射, 释放时直接 munmap; 其余的内存区块释放时先用 madvise(MADV_DONTNEED)
+// 归还整页的物理内存, 再放进空闲链表复用, 一个 slab 中的区块全部释放后整个 slab 被 munmap.
+// 所以内存池 trim() 或按 maxEmptyBlocks 释放的区块会真正还给系统. 不是线程安全的
+class MmapBlockProvider {
+public:
+    explicit MmapBlockProvider(const MmapBlockOptions& options = MmapBlockOptions());
+    // 复制只复制选项, 不共享已经映射的内存
+    MmapBlockProvider(const MmapBlockProvider& other) noexcept
+        : options_(other.options_) {
+    }
+    MmapBlockProvider(MmapBlockProvider&& other) noexcept;
+    MmapBlockProvider& operator=(const MmapBlockProvider&) = delete;
+    MmapBlockProvider& operator=(MmapBlockProvider&&) = delete;
+    ~MmapBlockProvider() noexcept;
+
+    void* allocate(size_t size, size_t alignment);
+    void deallocate(void* p, size_t size, size_t alignment) noexcept;
+
+    const MmapBlockOptions& options() const {
+        return options_;
+    }
+    // 当前映射的字节数
+    size_t mappedBytes() const {
+        return mappedBytes_;
+    }
+
+private:
+    struct FreeBlock_ {
+        FreeBlock_* next;
+    };
+    // 同一种大小和对齐的空闲内存区块
+    struct FreeList_ {
+        size_t size;
+        size_t alignment;
+        FreeBlock_* head;
+    };
+
+    static const size_t hugePageSize_ = size_t(2) << 20;
+
+    MmapBlockOptions options_;
+    // 所有的 slab (按 slabSize 对齐) -> 其中正在使用的区块个数
+    std::unordered_map<char*, size_t> slabs_;
+    std::vector<FreeList_> freeLists_;
+    // 当前 slab 中还没有切出的部分
+    char* current_ = nullptr;
+    char* end_ = nullptr;
+    size_t mappedBytes_ = 0;
+
+    // 映射 size 字节并按 alignment 对齐, hugeTLB 为 true 时先尝试预留的大页
+    char* map_(size_t size, size_t alignment, bool hugeTLB);
+    void unmap_(char* p, size_t size) noexcept;
+    // 区块全部释放后 munmap 整个 slab, 并把其中的区块从空闲链表中去掉
+    void releaseSlab_(char* slab) noexcept;
+    char* slabOf_(void* p) const {
+        return reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(options_.slabSize - 1));
+    }
+    static size_t pageSize_() {
+        static const size_t size = sysconf(_SC_PAGESIZE);
+        return size;
+    }
+};
+
+inline MmapBlockProvider::MmapBlockProvider(const MmapBlockOptions& options)
+    : options_(options) {
+    size_t slab = options_.slabSize;
+    if (slab == 0 || (slab & (slab - 1)) != 0 || slab % pageSize_() != 0)
+        throw std::invalid_argument("MmapBlockProvider: slabSize must be a power of two and a multiple of the page size");
+    if (options_.hugeTLB && slab % hugePageSize_ != 0)
+        throw std::invalid_argument("MmapBlockProvider: slabSize must be a multiple of 2MB with hugeTLB");
+}
+
+inline MmapBlockProvider::MmapBlockProvider(MmapBlockProvider&& other) noexcept
+    : options_(other.options_), slabs_(std::move(other.slabs_)), freeLists_(std::move(other.freeLists_)),
+      current_(other.current_), end_(other.end_), mappedBytes_(other.mappedBytes_) {
+    other.slabs_.clear();
+    other.freeLists_.clear();
+    other.current_ = other.end_ = nullptr;
+    other.mappedBytes_ = 0;
+}
+
+inline MmapBlockProvider::~MmapBlockProvider() noexcept {
+    for (std::unordered_map<char*, size_t>::iterator it = slabs_.begin(); it != slabs_.end(); ++it) {
+        unmap_(it->first, options_.slabSize);
+    }
+}
+
+inline void* MmapBlockProvider::allocate(size_t size, size_t alignment) {
+    if (alignment < alignof(FreeBlock_))
+        alignment = alignof(FreeBlock_);
+    if (size < sizeof(FreeBlock_))
+        size = sizeof(FreeBlock_);
+
+    // 大的请求单独映射
+    if (size > options_.slabSize / 2 || alignment > options_.slabSize) {
+        size_t page = pageSize_();
+        return map_((size + page - 1) / page * page, alignment, false);
+    }
+
+    // 先从空闲链表中取, 第一次遇到这种大小时建立空闲链表, 保证 deallocate 时不需要申请内存
+    FreeList_* list = nullptr;
+    for (size_t i = 0; i < freeLists_.size(); i++) {
+        if (freeLists_[i].size == size && freeLists_[i].alignment == alignment) {
+            list = &freeLists_[i];
+            break;
+        }
+    }
+    if (list == nullptr) {
+        freeLists_.push_back(FreeList_{size, alignment, nullptr});
+        list = &freeLists_.back();
+    }
+    if (list->head != nullptr) {
+        FreeBlock_* block = list->head;
+        list->head = block->next;
+        slabs_[slabOf_(block)]++;
+        return block;
+    }
+
+    // 从当前 slab 切出, 剩余的空间不够时映射一个新的 slab (新 slab 按 slabSize 对齐, 一定放得下)
+    char* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(current_) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (current_ == nullptr || p + size > end_) {
+        slabs_.reserve(slabs_.size() + 1);
+        char* slab = map_(options_.slabSize, options_.slabSize, options_.hugeTLB);
+        slabs_.emplace(slab, 0);
+        current_ = p = slab;
+        end_ = slab + options_.slabSize;
+    }
+    current_ = p + size;
+    slabs_[slabOf_(p)]++;
+    return p;
+}
+
+inline void MmapBlockProvider::deallocate(void* p, size_t size, size_t alignment) noexcept {
+    if (alignment < alignof(FreeBlock_))
+        alignment = alignof(FreeBlock_);
+    if (size < sizeof(FreeBlock_))
+        size = sizeof(FreeBlock_);
+
+    if (size > options_.slabSize / 2 || alignment > options_.slabSize) {
+        size_t page = pageSize_();
+        unmap_(static_cast<char*>(p), (size + page - 1) / page * page);
+        return;
+    }
+
+    char* slab = slabOf_(p);
+    std::unordered_map<char*, size_t>::iterator it = slabs_.find(slab);
+    if (it == slabs_.end())
+        return;
+    if (--it->second == 0) {
+        releaseSlab_(slab);
+        return;
+    }
+
+    // 区块中除了链表指针所在的页, 其余整页的物理内存先还给系统, 复用时再重新缺页
+    size_t page = pageSize_();
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + sizeof(FreeBlock_) + page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(p) + size) & ~(uintptr_t)(page - 1);
+    if (begin < end)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+
+    for (size_t i = 0; i < freeLists_.size(); i++) {
+        if (freeLists_[i].size == size && freeLists_[i].alignment == alignment) {
+            FreeBlock_* block = static_cast<FreeBlock_*>(p);
+            block->next = freeLists_[i].head;
+            freeLists_[i].head = block;
+            return;
+        }
+    }
+}
+
+inline void MmapBlockProvider::releaseSlab_(char* slab) noexcept {
+    for (size_t i = 0; i < freeLists_.size(); i++) {
+        FreeBlock_** link = &freeLists_[i].head;
+        while (*link != nullptr) {
+            if (slabOf_(*link) == slab)
+                *link = (*link)->next;
+            else
+                link = &(*link)->next;
+        }
+    }
+    // 正在切分的 slab 被释放后, 下一次分配重新映射 (current_ 可能已经等于 end_, 所以按 end_ - 1 判断)
+    if (end_ != nullptr && slabOf_(end_ - 1) == slab)
+        current_ = end_ = nullptr;
+
+    slabs_.erase(slab);
+    unmap_(slab, options_.slabSize);
+}
+
+inline char* MmapBlockProvider::map_(size_t size, size_t alignment, bool hugeTLB) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    size_t granule = pageSize_();
+#ifdef MAP_HUGETLB
+    if (hugeTLB) {
+        flags |= MAP_HUGETLB;
+        granule = hugePageSize_;
+    }
+#else
+    hugeTLB = false;
+#endif
+#ifdef MAP_POPULATE
+    // 透明大页和 NUMA 绑定都要在映射之后设置才能生效, 这时改为在设置之后触发缺页
+    bool populateLater = options_.populate && ((options_.hugePages && !hugeTLB) || options_.numaNode >= 0);
+    if (options_.populate && !populateLater)
+        flags |= MAP_POPULATE;
+#else
+    bool populateLater = options_.populate;
+#endif
+
+    // mmap 只保证按页 (或大页) 对齐, 更大的对齐要求多映射 alignment 字节, 再去掉首尾多余的部分
+    size_t extra = alignment > granule ? alignment : 0;
+    void* mapped = mmap(nullptr, size + extra, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mapped == MAP_FAILED) {
+        if (hugeTLB)
+            return map_(size, alignment, false);
+        throw std::bad_alloc();
+    }
+
+    char* base = static_cast<char*>(mapped);
+    char* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(base) + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (extra != 0) {
+        if (p != base)
+            munmap(base, p - base);
+        if (base + extra != p)
+            munmap(p + size, base + extra - p);
+    }
+    mappedBytes_ += size;
+
+#if defined(__linux__) && defined(SYS_mbind)
+    if (options_.numaNode >= 0 && options_.numaNode < 1024) {
+        const size_t bits = 8 * sizeof(unsigned long);
+        unsigned long nodeMask[1024 / bits] = {};
+        nodeMask[options_.numaNode / bits] |= 1UL << (options_.numaNode % bits);
+        // MPOL_PREFERRED, 失败时保持默认的 first-touch 策略
+        syscall(SYS_mbind, p, size, 1, nodeMask, 1024, 0);
+    }
+#endif
+#ifdef MADV_HUGEPAGE
+    if (options_.hugePages && !hugeTLB)
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+    if (populateLater) {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(p, size, MADV_POPULATE_WRITE) != 0)
+#endif
+        {
+            for (size_t i = 0; i < size; i += pageSize_()) {
+                static_cast<volatile char*>(p)[i] = 0;
+            }
+        }
+    }
+    return p;
+}
+
+inline void MmapBlockProvider::unmap_(char* p, size_t size) noexcept {
+    munmap(p, size);
+    mappedBytes_ -= size;
+}
+
+#endif
+
+#endif // BLOCK_PROVIDER_HPP
@@ -0,0 +1,88 @@
+// CacheAlignedMemoryPool 的示例: 每个对象独占一条缓存行, 不同线程频繁修改相邻分配的对象时不会伪共享;
+// 同时演示 alignas 要求更大对齐的类型也可以直接放进 MemoryPool
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "MemoryPool.hpp" // MemoryPool<T>, CacheAlignedMemoryPool<T>
+
+// 线程个数
+#define THREADS 4
+// 每个线程累加的次数
+#define INCREMENTS 10000000
+
+struct Counter {
+    std::atomic<long> value;
+};
+
+struct alignas(32) Vector4 {
+    double x, y, z, w;
+};
+
+// 每个线程累加自己的计数器, 计数器按顺序从 pool 分配, 返回耗时 (毫秒)
+template <typename Pool>
+long run(Pool& pool, bool& ok) {
+    std::vector<Counter*> counters;
+    for (int t = 0; t < THREADS; t++) {
+        counters.push_back(pool.allocate());
+        pool.construct(counters.back());
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.push_back(std::thread([&counters, t] {
+            for (long i = 0; i < INCREMENTS; i++) {
+                counters[t]->value.fetch_add(1, std::memory_order_relaxed);
+            }
+        }));
+    }
+    for (int t = 0; t < THREADS; t++) {
+        threads[t].join();
+    }
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    for (int t = 0; t < THREADS; t++) {
+        ok &= counters[t]->value.load() == INCREMENTS;
+        pool.destroy(counters[t]);
+        pool.deallocate(counters[t]);
+    }
+    return elapsed;
+}
+
+int main() {
+    bool ok = true;
+
+    // 相邻分配的对象在不同的缓存行中
+    CacheAlignedMemoryPool<Counter> alignedPool;
+    Counter* a = alignedPool.allocate();
+    Counter* b = alignedPool.allocate();
+    uintptr_t distance = reinterpret_cast<uintptr_t>(b) - reinterpret_cast<uintptr_t>(a);
+    ok &= reinterpret_cast<uintptr_t>(a) % memoryPoolCacheLine == 0 && distance == memoryPoolCacheLine;
+    std::cout << "CacheAlignedMemoryPool: adjacent objects " << distance << " bytes apart\n";
+    alignedPool.deallocate(b);
+    alignedPool.deallocate(a);
+
+    // 只有线程真正在多个核上并行时才能看到差别
+    MemoryPool<Counter> packedPool;
+    long packed = run(packedPool, ok);
+    long aligned = run(alignedPool, ok);
+    std::cout << THREADS << " threads, " << INCREMENTS << " increments each: packed " << packed << "ms, cache aligned " << aligned << "ms\n";
+
+    // 类型本身要求的对齐
+    MemoryPool<Vector4> vectorPool;
+    for (int i = 0; i < 1000; i++) {
+        Vector4* v = vectorPool.allocate();
+        ok &= reinterpret_cast<uintptr_t>(v) % alignof(Vector4) == 0;
+    }
+    Vector4* four = vectorPool.allocate(4);
+    ok &= reinterpret_cast<uintptr_t>(four) % alignof(Vector4) == 0;
+    vectorPool.deallocate(four, 4);
+    std::cout << "alignas(32) objects: " << (ok ? "ok" : "FAILED") << "\n";
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
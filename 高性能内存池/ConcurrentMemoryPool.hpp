@@ -0,0 +1,177 @@
+#ifndef CONCURRENT_MEMORY_POOL_HPP
+#define CONCURRENT_MEMORY_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// 可以被多个线程同时 allocate/deallocate 的内存池, 空闲对象槽组成一个无锁栈 (Treiber stack).
+// 栈顶是一个 64 位的带版本号指针, 每次修改栈顶版本号都加一, 避免 ABA 问题.
+// 用户态地址只有低 48 位 (x86-64 和 AArch64 的默认配置), 对象槽按 alignof(Slot_) (至少 8) 对齐,
+// 所以指针右移去掉对齐的低位后, 版本号至少有 16 + 3 = 19 位. 只有一个线程在读出栈顶和 CAS 之间停顿,
+// 期间其他线程恰好修改了 2^19 的整数倍次栈顶, 而且同一个对象槽又回到栈顶时, 才会发生 ABA.
+// 只有空闲对象槽用完时才加锁分配新的内存区块, 整块切好后一次 CAS 全部压入空闲栈.
+// 出栈时会读取栈顶对象槽中的 next, 这个对象槽可能刚被其他线程取走并写入对象,
+// 读到的旧值会因为版本号变化被 CAS 丢弃. 所以 next 不与对象共用内存 (每个对象槽多占一个指针),
+// 并且用 relaxed 原子操作读写, 用户写入对象和出栈读取 next 之间没有数据竞争;
+// 内存区块直到析构才释放, 读取本身总是安全的.
+// 这是对象池而不是标准库的分配器: 不能复制, 没有 rebind, 每次只分配一个对象 (例如无锁队列的节点)
+template <typename T, size_t BlockSize = 4096>
+class ConcurrentMemoryPool {
+public:
+    ConcurrentMemoryPool() noexcept = default;
+    ~ConcurrentMemoryPool() noexcept;
+
+    ConcurrentMemoryPool(const ConcurrentMemoryPool&) = delete;
+    ConcurrentMemoryPool& operator=(const ConcurrentMemoryPool&) = delete;
+
+    // 分配一个对象, n 不为 1 时抛出 std::bad_alloc; hint 会被忽略
+    T* allocate(size_t n = 1, const T* hint = 0);
+
+    // 调用构造函数
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    // n 只能是 1
+    void deallocate(T* p, size_t n = 1);
+
+    template <typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+private:
+    struct Slot_ {
+        std::atomic<Slot_*> next;
+        alignas(T) unsigned char element[sizeof(T)];
+    };
+
+    using data_pointer_ = char*;
+    using slot_type_ = Slot_;
+    using slot_pointer_ = Slot_*;
+
+    static constexpr int log2_(size_t n) {
+        return n <= 1 ? 0 : 1 + log2_(n / 2);
+    }
+
+    // 带版本号的栈顶: 低位是右移 alignShift_ 位的指针, 其余的高位是版本号
+    using tagged_pointer_ = uint64_t;
+    static const int addressBits_ = 48;
+    static const int alignShift_ = log2_(alignof(Slot_));
+    static const int tagShift_ = addressBits_ - alignShift_;
+    static const tagged_pointer_ pointerMask_ = (tagged_pointer_(1) << tagShift_) - 1;
+
+    // 空闲对象槽栈的栈顶
+    std::atomic<tagged_pointer_> freeSlots_{0};
+    // 分配新内存区块时加锁, 同一时间只有一个线程向系统申请内存
+    std::mutex growMutex_;
+    // 指向最新的内存区块, 区块头部保存前一个区块的地址, 只在持有 growMutex_ 时修改
+    slot_pointer_ currentBlock_{nullptr};
+
+    // 区块头部之后第一个对象槽的偏移, 按对象槽的对齐向上取整
+    static const size_t bodyOffset_ = (sizeof(slot_pointer_) + alignof(slot_type_) - 1) / alignof(slot_type_) * alignof(slot_type_);
+
+    static slot_pointer_ pointer_(tagged_pointer_ tagged) {
+        return reinterpret_cast<slot_pointer_>((tagged & pointerMask_) << alignShift_);
+    }
+    static tagged_pointer_ tagged_(slot_pointer_ p, tagged_pointer_ old) {
+        return ((old >> tagShift_) + 1) << tagShift_ | reinterpret_cast<tagged_pointer_>(p) >> alignShift_;
+    }
+
+    // 把 first ... last 这一串对象槽压入空闲栈
+    void push_(slot_pointer_ first, slot_pointer_ last);
+    slot_pointer_ pop_();
+    slot_pointer_ allocateBlock_();
+
+    static_assert(sizeof(void*) == 8, "ConcurrentMemoryPool needs 64-bit pointers.");
+    static_assert(sizeof(std::atomic<slot_pointer_>) == sizeof(slot_pointer_) && std::atomic<slot_pointer_>::is_always_lock_free,
+                  "ConcurrentMemoryPool needs lock-free atomic pointers.");
+    static_assert(BlockSize >= bodyOffset_ + 2 * sizeof(slot_type_), "BlockSize is too small.");
+};
+
+template <typename T, size_t BlockSize>
+T* ConcurrentMemoryPool<T, BlockSize>::allocate(size_t n, const T* /*hint*/) {
+    if (n != 1)
+        throw std::bad_alloc();
+
+    slot_pointer_ slot = pop_();
+    if (slot == nullptr)
+        slot = allocateBlock_();
+    return reinterpret_cast<T*>(slot->element);
+}
+
+template <typename T, size_t BlockSize>
+void ConcurrentMemoryPool<T, BlockSize>::deallocate(T* p, size_t /*n*/) {
+    if (p != nullptr) {
+        slot_pointer_ slot = reinterpret_cast<slot_pointer_>(reinterpret_cast<data_pointer_>(p) - offsetof(Slot_, element));
+        push_(slot, slot);
+    }
+}
+
+template <typename T, size_t BlockSize>
+void ConcurrentMemoryPool<T, BlockSize>::push_(slot_pointer_ first, slot_pointer_ last) {
+    tagged_pointer_ head = freeSlots_.load(std::memory_order_relaxed);
+    do {
+        last->next.store(pointer_(head), std::memory_order_relaxed);
+    } while (!freeSlots_.compare_exchange_weak(head, tagged_(first, head), std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <typename T, size_t BlockSize>
+typename ConcurrentMemoryPool<T, BlockSize>::slot_pointer_ ConcurrentMemoryPool<T, BlockSize>::pop_() {
+    tagged_pointer_ head = freeSlots_.load(std::memory_order_acquire);
+    while (pointer_(head) != nullptr) {
+        slot_pointer_ next = pointer_(head)->next.load(std::memory_order_relaxed);
+        if (freeSlots_.compare_exchange_weak(head, tagged_(next, head), std::memory_order_acquire, std::memory_order_acquire))
+            return pointer_(head);
+    }
+    return nullptr;
+}
+
+// 分配一个新的内存区块, 返回其中一个对象槽, 其余的对象槽压入空闲栈
+template <typename T, size_t BlockSize>
+typename ConcurrentMemoryPool<T, BlockSize>::slot_pointer_ ConcurrentMemoryPool<T, BlockSize>::allocateBlock_() {
+    std::lock_guard<std::mutex> lock(growMutex_);
+
+    // 等锁期间其他线程可能已经分配了新的内存区块
+    slot_pointer_ slot = pop_();
+    if (slot != nullptr)
+        return slot;
+
+    data_pointer_ newBlock = (data_pointer_)(operator new(BlockSize, std::align_val_t(alignof(slot_type_))));
+    if ((reinterpret_cast<tagged_pointer_>(newBlock) >> addressBits_) != 0) {
+        ::operator delete(newBlock, std::align_val_t(alignof(slot_type_)));
+        throw std::bad_alloc();
+    }
+    reinterpret_cast<slot_pointer_>(newBlock)->next.store(currentBlock_, std::memory_order_relaxed);
+    currentBlock_ = reinterpret_cast<slot_pointer_>(newBlock);
+
+    data_pointer_ body = newBlock + bodyOffset_;
+    size_t slotCount = (BlockSize - bodyOffset_) / sizeof(slot_type_);
+    slot_pointer_ first = reinterpret_cast<slot_pointer_>(body);
+
+    // 第一个对象槽直接返回, 其余的串成链表一次压栈
+    for (size_t i = 1; i + 1 < slotCount; i++) {
+        first[i].next.store(&first[i + 1], std::memory_order_relaxed);
+    }
+    if (slotCount > 1)
+        push_(&first[1], &first[slotCount - 1]);
+
+    return first;
+}
+
+template <typename T, size_t BlockSize>
+ConcurrentMemoryPool<T, BlockSize>::~ConcurrentMemoryPool() noexcept {
+    slot_pointer_ curr = currentBlock_;
+    while (curr != nullptr) {
+        slot_pointer_ prev = curr->next.load(std::memory_order_relaxed);
+        ::operator delete(curr, std::align_val_t(alignof(slot_type_)));
+        curr = prev;
+    }
+}
+
+#endif // CONCURRENT_MEMORY_POOL_HPP
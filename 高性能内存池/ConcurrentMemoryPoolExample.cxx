@@ -0,0 +1,74 @@
+// ConcurrentMemoryPool 的示例: 多个线程同时从无锁的空闲栈分配和释放,
+// 检查同一个对象槽不会同时分给两个线程. 可以用 -fsanitize=thread 编译检查数据竞争
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentMemoryPool.hpp" // ConcurrentMemoryPool<T>
+
+// 线程个数
+#define THREADS 8
+// 每个线程的操作次数
+#define OPS 200000
+// 每个线程最多同时持有的对象个数
+#define HELD 64
+
+struct Item {
+    // 持有这个对象的线程编号 + 1, 0 表示空闲
+    std::atomic<int> owner;
+    long value;
+};
+
+int main() {
+    bool ok = true;
+
+    // 每次只能分配一个对象, 要求连续的多个对象时抛出 std::bad_alloc
+    ConcurrentMemoryPool<Item> pool;
+    try {
+        pool.allocate(2);
+        ok = false;
+    } catch (const std::bad_alloc&) {
+    }
+    std::cout << "allocate(2): " << (ok ? "rejected" : "FAILED") << "\n";
+
+    std::atomic<long> errors(0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; t++) {
+        threads.push_back(std::thread([&, t] {
+            std::vector<Item*> held;
+            for (int i = 0; i < OPS; i++) {
+                if (held.size() < HELD && i % 3 != 0) {
+                    Item* item = pool.allocate();
+                    pool.construct(item);
+                    item->owner.store(t + 1);
+                    item->value = static_cast<long>(t) * OPS + i;
+                    held.push_back(item);
+                } else if (!held.empty()) {
+                    // 同一个对象槽如果同时分给了其他线程, owner 或 value 会被改写
+                    Item* item = held.back();
+                    held.pop_back();
+                    if (item->owner.exchange(0) != t + 1 || item->value / OPS != t)
+                        errors++;
+                    pool.deallocate(item);
+                }
+            }
+            for (size_t i = 0; i < held.size(); i++) {
+                if (held[i]->owner.exchange(0) != t + 1 || held[i]->value / OPS != t)
+                    errors++;
+                pool.deallocate(held[i]);
+            }
+        }));
+    }
+    for (int t = 0; t < THREADS; t++) {
+        threads[t].join();
+    }
+
+    ok &= errors == 0;
+    std::cout << THREADS << " threads: " << errors << " errors\n";
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -3,40 +3,108 @@
 
 #include <climits>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
-template <typename T, size_t BlockSize = 4096>
-class MemoryPool {
-public:
-    template <typename U>
-    struct rebind {
-        using other = MemoryPool<U>;
-    };
+#include "BlockProvider.hpp"
 
-    MemoryPool() noexcept = default;
-    ~MemoryPool() noexcept;
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
-    // 同一时间只能分配一个对象, n 和 hint 会被忽略
-    T* allocate(size_t n = 1, const T* hint = 0);
+// 空闲内存区块的保留策略
+struct MemoryPoolRetention {
+    // 最多保留多少个完全空闲的内存区块, 超出时立即归还
+    size_t maxEmptyBlocks = SIZE_MAX;
+    // 为 true 时用 madvise(MADV_DONTNEED) 归还区块中的整页物理内存, 区块的地址空间留给之后复用;
+    // 为 false 时把整个区块还给 BlockProvider
+    bool adviseOnly = false;
+};
 
-    // 调用构造函数
-    template <typename U, typename... Args>
-    void construct(U* p, Args&&... args);
+// 内存区块的增长策略: 第一次申请 initialBlocks 个区块, 之后每次翻倍, 直到 maxBlocks 个.
+// 每次只向 BlockProvider 申请一段连续的内存 (region) 再切成区块, 暂时用不到的区块留作备用
+struct MemoryPoolGrowth {
+    size_t initialBlocks = 1;
+    size_t maxBlocks = 16;
+};
 
-    // 销毁指针 p 指向的内存区块
+// 缓存行的大小
+constexpr size_t memoryPoolCacheLine = 64;
+
+// 内存池的实现: 一个对象独占自己的内存区块, 不能复制和移动, 由 MemoryPool 共享使用.
+// 内存区块由 BlockProvider 提供, 默认使用 operator new, 也可以使用 MmapBlockProvider 从大页中切出.
+// 对象槽按 alignof(T) 对齐; Alignment 可以要求更大的对齐, 对象槽的大小也随之补齐,
+// 例如按缓存行对齐后相邻的对象不会共享缓存行 (见 CacheAlignedMemoryPool)
+template <typename T, size_t BlockSize = 4096, typename BlockProvider = NewBlockProvider, size_t Alignment = 0>
+class MemoryPoolCore {
+public:
+    explicit MemoryPoolCore(const BlockProvider& provider = BlockProvider(), const MemoryPoolRetention& retention = MemoryPoolRetention(),
+                            const MemoryPoolGrowth& growth = MemoryPoolGrowth())
+        : provider_(provider), retention_(retention), growth_(growth), refillBlocks_(growth_.initialBlocks) {
+    }
+    MemoryPoolCore(const MemoryPoolCore&) = delete;
+    MemoryPoolCore& operator=(const MemoryPoolCore&) = delete;
+    ~MemoryPoolCore() noexcept;
+
+    // n 为 1 时分配一个对象槽; n 大于 1 时分配 n 个连续的对象槽,
+    // 超过一个内存区块容量的请求直接使用 operator new
+    T* allocate(size_t n = 1);
+
+    // 销毁指针 p 指向的内存区块, n 需要与 allocate 时相同
     void deallocate(T* p, size_t n = 1);
 
-    // 销毁内存池中的对象, 即调用对象的析构函数
-    template <typename U>
-    void destroy(U* p) {
-        p->~U();
+    const BlockProvider& provider() const {
+        return provider_;
+    }
+    const MemoryPoolRetention& retention() const {
+        return retention_;
+    }
+    void setRetention(const MemoryPoolRetention& retention) {
+        retention_ = retention;
+    }
+    const MemoryPoolGrowth& growth() const {
+        return growth_;
+    }
+    // 重新开始按 initialBlocks 增长
+    void setGrowth(const MemoryPoolGrowth& growth) {
+        growth_ = growth;
+        refillBlocks_ = growth_.initialBlocks;
+    }
+
+    // 预先申请内存区块, 保证之后至少 n 个对象的单个分配不需要再向 BlockProvider 申请内存;
+    // prefault 为 true 时同时触发这些内存的缺页, 热路径上不再有缺页中断
+    void reserve(size_t n, bool prefault = false);
+    // 归还所有完全空闲的内存区块 (先把缓存的连续对象槽拆回各自的区块), 返回归还的区块个数.
+    // 没有设置 adviseOnly 时备用的区块也一起归还
+    size_t trim();
+
+    // 持有的内存区块个数, 其中完全空闲的个数, 以及还没有使用 (或已经 madvise 归还物理内存) 的备用区块个数
+    size_t blockCount() const {
+        return blockCount_;
+    }
+    size_t emptyBlockCount() const {
+        return emptyCount_;
+    }
+    size_t spareBlockCount() const {
+        return spareCount_;
     }
 
 private:
+    // 对象槽的对齐: 满足 T 和槽指针的对齐, 以及 Alignment 的要求
+    static constexpr size_t max_(size_t a, size_t b) {
+        return a > b ? a : b;
+    }
+    static constexpr size_t slotAlignment_ = max_(max_(alignof(T), alignof(void*)), Alignment);
+
     // 用于存储内存池中的对象槽,
     // 要么被实例化为一个存放对象的槽,
     // 要么被实例化为一个指向存放对象槽的槽指针
-    union Slot_ {
+    union alignas(slotAlignment_) Slot_ {
         T element;
         Slot_* next;
     };
@@ -48,73 +116,613 @@ private:
     // 对象槽指针
     using slot_pointer_ = Slot_*;
 
-    // 指向当前内存区块
-    slot_pointer_ currentBlock_{nullptr};
+    // 内存区块按 BlockSize 对齐, 头部记录区块的使用情况, 释放对象槽时由地址直接找到所在的区块
+    struct BlockHeader_ {
+        // 所有内存区块组成的链表
+        BlockHeader_* prev;
+        BlockHeader_* next;
+        // 有空闲对象槽的内存区块组成的链表 (部分空闲或完全空闲)
+        BlockHeader_* freePrev;
+        BlockHeader_* freeNext;
+        // 区块中已释放的对象槽
+        slot_pointer_ freeSlots;
+        // 区块中正在使用的对象槽个数
+        size_t live;
+        // 区块所在的 region 的第一个区块; 只有第一个区块的 regionBlocks 和 regionLive 有效:
+        // region 中的区块个数, 以及还没有释放的区块个数
+        BlockHeader_* region;
+        uint32_t regionBlocks;
+        uint32_t regionLive;
+    };
+    using block_pointer_ = BlockHeader_*;
+
+    BlockProvider provider_;
+
+    // 指向当前内存区块, 新的对象槽从这里依次切出
+    block_pointer_ currentBlock_{nullptr};
     // 指向当前内存区块的一个对象槽
     slot_pointer_ currentSlot_{nullptr};
     // 指向当前内存区块的最后一个对象槽
     slot_pointer_ lastSlot_{nullptr};
-    // 指向当前内存区块中的空闲对象槽
-    slot_pointer_ freeSlots_{nullptr};
+
+    // 所有内存区块
+    block_pointer_ blocks_{nullptr};
+    // 部分空闲的内存区块, 优先从这里分配
+    block_pointer_ partialBlocks_{nullptr};
+    // 完全空闲的内存区块
+    block_pointer_ emptyBlocks_{nullptr};
+    // 备用的区块: 按增长策略多申请的, reserve() 预留的, 以及已经 madvise 归还物理内存的;
+    // 需要新的内存区块时先使用它们 (通过 freeNext 串联)
+    block_pointer_ spareBlocks_{nullptr};
+    size_t blockCount_{0};
+    size_t emptyCount_{0};
+    size_t spareCount_{0};
+    MemoryPoolRetention retention_;
+    MemoryPoolGrowth growth_;
+    // 下一次申请的区块个数
+    size_t refillBlocks_{growth_.initialBlocks};
+
+    // 长度不超过 runLists_ 的连续对象槽释放后按长度分别串成链表, 每段的第一个对象槽指向下一段
+    static const size_t runLists_ = 16;
+    slot_pointer_ freeRuns_[runLists_ + 1]{};
+
+    // 区块头部之后第一个对象槽的偏移
+    static const size_t bodyOffset_ = (sizeof(BlockHeader_) + alignof(slot_type_) - 1) / alignof(slot_type_) * alignof(slot_type_);
+    // 一个内存区块中的对象槽个数
+    static const size_t slotsPerBlock_ = (BlockSize - bodyOffset_) / sizeof(slot_type_);
+
+    static block_pointer_ blockOf_(const void* p) {
+        return reinterpret_cast<block_pointer_>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(BlockSize - 1));
+    }
+    static void link_(block_pointer_& head, block_pointer_ block);
+    static void unlink_(block_pointer_& head, block_pointer_ block);
+
+    // 从 BlockProvider 申请一段连续的内存, 切成 count 个区块 (最多 UINT32_MAX 个) 放入备用区块, 返回区块个数
+    size_t newRegion_(size_t count);
+    // 分配一个新的内存区块, 作为当前内存区块
+    void allocateBlock_();
+    // 从当前内存区块切出 n 个连续的对象槽
+    slot_pointer_ allocateRun_(size_t n);
+    // 把一个对象槽还给它所在的区块
+    void deallocateSlot_(slot_pointer_ slot);
+    // 按保留策略归还一个完全空闲的区块
+    void releaseBlock_(block_pointer_ block);
+    // 释放一个区块: region 中的区块全部释放后把整个 region 还给 BlockProvider,
+    // 在此之前只用 madvise 归还区块中的整页物理内存
+    void freeBlock_(block_pointer_ block);
+    // 区块头部所在的页之后的整页
+    static void adviseFree_(block_pointer_ block);
+    // 触发 [begin, end) 中每一页的缺页
+    static void prefault_(data_pointer_ begin, data_pointer_ end);
 
     // 检查定义的内存池大小是否过小
-    static_assert(BlockSize >= 2 * sizeof(slot_type_), "BlockSize is too small.");
+    static_assert(BlockSize >= bodyOffset_ + 2 * sizeof(slot_type_), "BlockSize is too small.");
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two.");
+    static_assert((Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two.");
 };
 
-template <typename T, size_t BlockSize>
-T* MemoryPool<T, BlockSize>::allocate(size_t /*n*/, const T* /*hint*/) {
-    if (freeSlots_ != nullptr) {
-        // 从空闲对象槽中分配一个对象
-        T* result = (T*)freeSlots_;
-        freeSlots_ = freeSlots_->next;
+// 通过复制和 rebind 联系在一起的一组 MemoryPool 共享的状态: 每种对象类型一个 MemoryPoolCore,
+// 以及创建新的 MemoryPoolCore 时使用的设置. 最后一个 MemoryPool 销毁时所有内存一起释放
+template <size_t BlockSize, typename BlockProvider, size_t Alignment>
+class MemoryPoolFamily_ {
+public:
+    explicit MemoryPoolFamily_(const BlockProvider& provider)
+        : provider_(provider) {
+    }
+    MemoryPoolFamily_(const MemoryPoolFamily_&) = delete;
+    MemoryPoolFamily_& operator=(const MemoryPoolFamily_&) = delete;
+    ~MemoryPoolFamily_() noexcept {
+        for (size_t i = cores_.size(); i-- > 0;) {
+            cores_[i].destroy(cores_[i].core);
+        }
+    }
+
+    // 对象类型 U 的 MemoryPoolCore, 不存在时返回 nullptr
+    template <typename U>
+    MemoryPoolCore<U, BlockSize, BlockProvider, Alignment>* find() const noexcept {
+        for (size_t i = 0; i < cores_.size(); i++) {
+            if (cores_[i].type == typeKey_<U>())
+                return static_cast<MemoryPoolCore<U, BlockSize, BlockProvider, Alignment>*>(cores_[i].core);
+        }
+        return nullptr;
+    }
+    // 对象类型 U 的 MemoryPoolCore, 不存在时按当前的设置创建
+    template <typename U>
+    MemoryPoolCore<U, BlockSize, BlockProvider, Alignment>* get() {
+        using core_type = MemoryPoolCore<U, BlockSize, BlockProvider, Alignment>;
+        if (core_type* core = find<U>())
+            return core;
+        cores_.reserve(cores_.size() + 1);
+        core_type* core = new core_type(provider_, retention, growth);
+        cores_.push_back(Entry_{typeKey_<U>(), core, [](void* p) noexcept { delete static_cast<core_type*>(p); }});
+        return core;
+    }
+
+    const BlockProvider& provider() const {
+        return provider_;
+    }
+
+    // 之后创建的 MemoryPoolCore 使用的设置
+    MemoryPoolRetention retention;
+    MemoryPoolGrowth growth;
+
+private:
+    struct Entry_ {
+        const void* type;
+        void* core;
+        void (*destroy)(void*) noexcept;
+    };
+
+    // 每种对象类型一个唯一的地址
+    template <typename U>
+    static const void* typeKey_() noexcept {
+        static const char key = 0;
+        return &key;
+    }
+
+    BlockProvider provider_;
+    std::vector<Entry_> cores_;
+};
+
+// 标准库风格的分配器. 复制和 rebind 得到的 MemoryPool 共享同一组内存池 (每种对象类型一个 MemoryPoolCore),
+// 互相之间可以释放对方分配的内存, 所以可以用于所有标准容器, 包括会用临时 rebind 的分配器
+// 分配内部数组的 std::deque 和 std::unordered_map. 共享同一组内存池的 MemoryPool 不能在多个线程中同时使用
+template <typename T, size_t BlockSize = 4096, typename BlockProvider = NewBlockProvider, size_t Alignment = 0>
+class MemoryPool {
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    // 容器复制时新容器使用一组新的内存池 (只复制设置), 移动和交换时内存池跟随元素
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U>
+    struct rebind {
+        using other = MemoryPool<U, BlockSize, BlockProvider, Alignment>;
+    };
+
+    MemoryPool()
+        : MemoryPool(BlockProvider()) {
+    }
+    explicit MemoryPool(const BlockProvider& provider)
+        : family_(std::make_shared<family_type_>(provider)), core_(family_->template get<T>()) {
+    }
+    // 复制和 rebind 共享同一组内存池; 移动也是复制, 原来的对象仍然可以使用
+    MemoryPool(const MemoryPool& other) noexcept = default;
+    template <typename U>
+    MemoryPool(const MemoryPool<U, BlockSize, BlockProvider, Alignment>& other) noexcept
+        : family_(other.family_), core_(nullptr) {
+    }
+    MemoryPool& operator=(const MemoryPool& other) noexcept = default;
+
+    // 容器的复制构造使用一组新的空内存池, 只复制这个内存池的设置
+    MemoryPool select_on_container_copy_construction() const {
+        MemoryPool result(provider());
+        result.setRetention(retention());
+        result.setGrowth(growth());
         return result;
-    } 
+    }
+
+    // n 为 1 时分配一个对象槽; n 大于 1 时分配 n 个连续的对象槽,
+    // 超过一个内存区块容量的请求直接使用 operator new. hint 会被忽略
+    T* allocate(size_t n = 1, const T* /*hint*/ = 0) {
+        return pool_().allocate(n);
+    }
+
+    // 调用构造函数
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    // 销毁指针 p 指向的内存区块, n 需要与 allocate 时相同
+    void deallocate(T* p, size_t n = 1) {
+        pool_().deallocate(p, n);
+    }
+
+    // 销毁内存池中的对象, 即调用对象的析构函数
+    template <typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+    // 共享同一组内存池时相等
+    template <typename U>
+    bool operator==(const MemoryPool<U, BlockSize, BlockProvider, Alignment>& other) const noexcept {
+        return family_ == other.family_;
+    }
+    template <typename U>
+    bool operator!=(const MemoryPool<U, BlockSize, BlockProvider, Alignment>& other) const noexcept {
+        return family_ != other.family_;
+    }
+
+    const BlockProvider& provider() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->provider() : family_->provider();
+    }
+    const MemoryPoolRetention& retention() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->retention() : family_->retention;
+    }
+    // 修改这个对象类型的内存池, 之后 rebind 出来的新的对象类型也使用这个设置
+    void setRetention(const MemoryPoolRetention& retention) {
+        pool_().setRetention(retention);
+        family_->retention = retention;
+    }
+    const MemoryPoolGrowth& growth() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->growth() : family_->growth;
+    }
+    // 重新开始按 initialBlocks 增长
+    void setGrowth(const MemoryPoolGrowth& growth) {
+        pool_().setGrowth(growth);
+        family_->growth = growth;
+    }
+
+    // 以下操作只针对对象类型 T 的内存池, 含义见 MemoryPoolCore
+    void reserve(size_t n, bool prefault = false) {
+        pool_().reserve(n, prefault);
+    }
+    size_t trim() {
+        return pool_().trim();
+    }
+    size_t blockCount() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->blockCount() : 0;
+    }
+    size_t emptyBlockCount() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->emptyBlockCount() : 0;
+    }
+    size_t spareBlockCount() const {
+        const core_type_* core = peek_();
+        return core != nullptr ? core->spareBlockCount() : 0;
+    }
+
+private:
+    template <typename U, size_t, typename, size_t>
+    friend class MemoryPool;
+
+    using family_type_ = MemoryPoolFamily_<BlockSize, BlockProvider, Alignment>;
+    using core_type_ = MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>;
+
+    std::shared_ptr<family_type_> family_;
+    // family_ 中对象类型 T 的内存池; rebind 得到的对象在第一次使用时才查找或创建
+    core_type_* core_;
+
+    core_type_& pool_() {
+        if (core_ == nullptr)
+            core_ = family_->template get<T>();
+        return *core_;
+    }
+    const core_type_* peek_() const noexcept {
+        return core_ != nullptr ? core_ : family_->template find<T>();
+    }
+};
+
+// 每个对象独占缓存行的内存池, 适合被不同线程频繁修改的小对象 (计数器, 队列节点等), 避免伪共享
+template <typename T, size_t BlockSize = 4096, typename BlockProvider = NewBlockProvider>
+using CacheAlignedMemoryPool = MemoryPool<T, BlockSize, BlockProvider, memoryPoolCacheLine>;
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::link_(block_pointer_& head, block_pointer_ block) {
+    block->freePrev = nullptr;
+    block->freeNext = head;
+    if (head != nullptr)
+        head->freePrev = block;
+    head = block;
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::unlink_(block_pointer_& head, block_pointer_ block) {
+    if (block->freePrev != nullptr)
+        block->freePrev->freeNext = block->freeNext;
+    else
+        head = block->freeNext;
+    if (block->freeNext != nullptr)
+        block->freeNext->freePrev = block->freePrev;
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+T* MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::allocate(size_t n) {
+    if (n > 1) {
+        // 超过一个内存区块的请求直接向系统申请
+        if (n > slotsPerBlock_)
+            return static_cast<T*>(operator new(n * sizeof(T), std::align_val_t(alignof(slot_type_))));
+        if (n <= runLists_ && freeRuns_[n] != nullptr) {
+            slot_pointer_ run = freeRuns_[n];
+            freeRuns_[n] = run->next;
+            return reinterpret_cast<T*>(run);
+        }
+        return reinterpret_cast<T*>(allocateRun_(n));
+    }
+
+    // 从部分空闲的区块中分配, 没有时再动用完全空闲的区块
+    block_pointer_ block = partialBlocks_;
+    if (block == nullptr && emptyBlocks_ != nullptr) {
+        block = emptyBlocks_;
+        unlink_(emptyBlocks_, block);
+        link_(partialBlocks_, block);
+        emptyCount_--;
+    }
+    if (block != nullptr) {
+        // 从空闲对象槽中分配一个对象
+        slot_pointer_ result = block->freeSlots;
+        block->freeSlots = result->next;
+        block->live++;
+        if (block->freeSlots == nullptr)
+            unlink_(partialBlocks_, block);
+        return reinterpret_cast<T*>(result);
+    }
     // 当前内存区块中的对象槽已经用完, 需要分配新的内存区块
     if (currentSlot_ >= lastSlot_) {
-        // 分配内存区块
-        data_pointer_ newBlock = (data_pointer_)(operator new(BlockSize));
-        // 将内存区块的头部作为一个指针, 指向下一个内存区块
-        reinterpret_cast<slot_pointer_>(newBlock)->next = currentBlock_;
-        currentBlock_ = reinterpret_cast<slot_pointer_>(newBlock);
-        // 计算出内存区块中的对象槽的个数
-        data_pointer_ body = newBlock + sizeof(slot_pointer_);
-        size_t bodySize = BlockSize - sizeof(slot_pointer_);
-        size_t slotCount = bodySize / sizeof(slot_type_);
-        // 计算出内存区块中的最后一个对象槽
-        lastSlot_ = reinterpret_cast<slot_pointer_>(body + slotCount * sizeof(slot_type_));
-        // 计算出内存区块中的第一个对象槽
-        currentSlot_ = reinterpret_cast<slot_pointer_>(body);
+        allocateBlock_();
     }
     // 从当前内存区块中分配一个对象
+    currentBlock_->live++;
     return reinterpret_cast<T*>(currentSlot_++);
 }
 
-// construct()函数的实现
-template <typename T, size_t BlockSize>
-template <typename U, typename... Args>
-void MemoryPool<T, BlockSize>::construct(U* p, Args&&... args) {
-    new (p) U(std::forward<Args>(args)...);
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+size_t MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::newRegion_(size_t count) {
+    if (count > UINT32_MAX)
+        count = UINT32_MAX;
+    if (count > SIZE_MAX / BlockSize)
+        throw std::bad_alloc();
+
+    data_pointer_ region = static_cast<data_pointer_>(provider_.allocate(count * BlockSize, BlockSize));
+    block_pointer_ first = reinterpret_cast<block_pointer_>(region);
+    first->regionBlocks = static_cast<uint32_t>(count);
+    first->regionLive = static_cast<uint32_t>(count);
+
+    // 倒序放入备用区块, 之后按地址顺序使用
+    for (size_t i = count; i-- > 0;) {
+        block_pointer_ header = reinterpret_cast<block_pointer_>(region + i * BlockSize);
+        header->region = first;
+        // 加入所有内存区块的链表
+        header->prev = nullptr;
+        header->next = blocks_;
+        if (blocks_ != nullptr)
+            blocks_->prev = header;
+        blocks_ = header;
+
+        header->freeNext = spareBlocks_;
+        spareBlocks_ = header;
+    }
+    blockCount_ += count;
+    spareCount_ += count;
+    return count;
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::allocateBlock_() {
+    if (spareBlocks_ == nullptr) {
+        // 按增长策略一次申请多个内存区块
+        newRegion_(refillBlocks_ > 0 ? refillBlocks_ : 1);
+        if (refillBlocks_ < growth_.maxBlocks)
+            refillBlocks_ = refillBlocks_ * 2 < growth_.maxBlocks ? refillBlocks_ * 2 : growth_.maxBlocks;
+    }
+
+    block_pointer_ header = spareBlocks_;
+    spareBlocks_ = header->freeNext;
+    spareCount_--;
+
+    data_pointer_ newBlock = reinterpret_cast<data_pointer_>(header);
+    header->freePrev = header->freeNext = nullptr;
+    header->freeSlots = nullptr;
+    header->live = 0;
+    currentBlock_ = header;
+    // 计算出内存区块中的第一个对象槽
+    currentSlot_ = reinterpret_cast<slot_pointer_>(newBlock + bodyOffset_);
+    // 计算出内存区块中的最后一个对象槽
+    lastSlot_ = currentSlot_ + slotsPerBlock_;
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::reserve(size_t n, bool prefault) {
+    // 只计算当前内存区块剩余的和备用区块中的对象槽, 已释放的对象槽不计算在内
+    size_t available = currentSlot_ < lastSlot_ ? lastSlot_ - currentSlot_ : 0;
+    size_t spare = spareCount_ * slotsPerBlock_;
+    // 缺少的区块一次申请
+    while (available + spare < n) {
+        spare += newRegion_((n - available - spare + slotsPerBlock_ - 1) / slotsPerBlock_) * slotsPerBlock_;
+    }
+
+    if (prefault) {
+        if (currentSlot_ < lastSlot_)
+            prefault_(reinterpret_cast<data_pointer_>(currentSlot_), reinterpret_cast<data_pointer_>(lastSlot_));
+        for (block_pointer_ block = spareBlocks_; block != nullptr; block = block->freeNext) {
+            prefault_(reinterpret_cast<data_pointer_>(block), reinterpret_cast<data_pointer_>(block) + BlockSize);
+        }
+    }
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::prefault_(data_pointer_ begin, data_pointer_ end) {
+#if defined(__unix__) || defined(__APPLE__)
+    static const size_t page = sysconf(_SC_PAGESIZE);
+#else
+    static const size_t page = 4096;
+#endif
+    // 原样写回读到的值, 不会改动区块头部和正在使用的对象
+    volatile char* p = begin;
+    for (; p < end; p += page - reinterpret_cast<uintptr_t>(p) % page) {
+        *p = *p;
+    }
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+typename MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::slot_pointer_ MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::allocateRun_(size_t n) {
+    if (currentSlot_ == nullptr || static_cast<size_t>(lastSlot_ - currentSlot_) < n) {
+        // 当前内存区块剩余的对象槽不够, 放入区块的空闲对象槽链表后换一个新的内存区块
+        if (currentSlot_ < lastSlot_) {
+            if (currentBlock_->freeSlots == nullptr)
+                link_(partialBlocks_, currentBlock_);
+            while (currentSlot_ < lastSlot_) {
+                currentSlot_->next = currentBlock_->freeSlots;
+                currentBlock_->freeSlots = currentSlot_++;
+            }
+        }
+        allocateBlock_();
+    } else if (currentBlock_->live == 0 && currentBlock_->freeSlots != nullptr) {
+        // 当前内存区块在完全空闲的链表中, 切出对象槽后不再是完全空闲的
+        unlink_(emptyBlocks_, currentBlock_);
+        link_(partialBlocks_, currentBlock_);
+        emptyCount_--;
+    }
+    slot_pointer_ result = currentSlot_;
+    currentSlot_ += n;
+    currentBlock_->live += n;
+    return result;
 }
 
 // deallocate()函数的实现
-template <typename T, size_t BlockSize>
-void MemoryPool<T, BlockSize>::deallocate(T* p, size_t /*n*/) {
-    if (p != nullptr) {
-        // 将对象槽插入到空闲对象槽链表中
-        reinterpret_cast<slot_pointer_>(p)->next = freeSlots_;
-        freeSlots_ = (slot_pointer_)(p);
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::deallocate(T* p, size_t n) {
+    if (p != nullptr && n > 1) {
+        if (n > slotsPerBlock_) {
+            ::operator delete(p, std::align_val_t(alignof(slot_type_)));
+        } else if (n <= runLists_) {
+            slot_pointer_ run = reinterpret_cast<slot_pointer_>(p);
+            run->next = freeRuns_[n];
+            freeRuns_[n] = run;
+        } else {
+            // 较长的连续对象槽拆开还给所在的区块
+            slot_pointer_ slot = reinterpret_cast<slot_pointer_>(p);
+            for (size_t i = 0; i < n; i++) {
+                deallocateSlot_(&slot[i]);
+            }
+        }
+    } else if (p != nullptr) {
+        deallocateSlot_(reinterpret_cast<slot_pointer_>(p));
+    }
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::deallocateSlot_(slot_pointer_ slot) {
+    block_pointer_ block = blockOf_(slot);
+
+    // 将对象槽插入到区块的空闲对象槽链表中, 之前已满的区块加入部分空闲链表
+    if (block->freeSlots == nullptr)
+        link_(partialBlocks_, block);
+    slot->next = block->freeSlots;
+    block->freeSlots = slot;
+
+    if (--block->live == 0) {
+        unlink_(partialBlocks_, block);
+        link_(emptyBlocks_, block);
+        emptyCount_++;
+        if (emptyCount_ > retention_.maxEmptyBlocks)
+            releaseBlock_(block);
+    }
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::releaseBlock_(block_pointer_ block) {
+    unlink_(emptyBlocks_, block);
+    emptyCount_--;
+
+    if (block == currentBlock_) {
+        currentBlock_ = nullptr;
+        currentSlot_ = lastSlot_ = nullptr;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    if (retention_.adviseOnly) {
+        // 头部所在的页保留, 区块仍然记录在所有区块的链表中
+        adviseFree_(block);
+        block->freeSlots = nullptr;
+        block->freeNext = spareBlocks_;
+        spareBlocks_ = block;
+        spareCount_++;
+        return;
+    }
+#endif
+
+    freeBlock_(block);
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::freeBlock_(block_pointer_ block) {
+    if (block->prev != nullptr)
+        block->prev->next = block->next;
+    else
+        blocks_ = block->next;
+    if (block->next != nullptr)
+        block->next->prev = block->prev;
+    blockCount_--;
+
+    block_pointer_ region = block->region;
+    if (--region->regionLive == 0)
+        provider_.deallocate(region, region->regionBlocks * BlockSize, BlockSize);
+    else
+        adviseFree_(block);
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+void MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::adviseFree_(block_pointer_ block) {
+#if defined(__unix__) || defined(__APPLE__)
+    // 区块头部 (以及 region 的信息) 所在的页不能归还
+    static const uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(block) + sizeof(BlockHeader_) + page - 1) & ~(page - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(block) + BlockSize;
+    if (begin < end)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+#else
+    (void)block;
+#endif
+}
+
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+size_t MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::trim() {
+    // 缓存的连续对象槽会让所在的区块一直处于使用中, 先拆开还给区块
+    for (size_t n = 2; n <= runLists_; n++) {
+        while (freeRuns_[n] != nullptr) {
+            slot_pointer_ run = freeRuns_[n];
+            freeRuns_[n] = run->next;
+            for (size_t i = 0; i < n; i++) {
+                deallocateSlot_(&run[i]);
+            }
+        }
+    }
+
+    size_t count = 0;
+    while (emptyBlocks_ != nullptr) {
+        releaseBlock_(emptyBlocks_);
+        count++;
+    }
+    if (!retention_.adviseOnly) {
+        while (spareBlocks_ != nullptr) {
+            block_pointer_ block = spareBlocks_;
+            spareBlocks_ = block->freeNext;
+            spareCount_--;
+            freeBlock_(block);
+            count++;
+        }
     }
+    return count;
 }
 
 // 析构函数的实现
-template <typename T, size_t BlockSize>
-MemoryPool<T, BlockSize>::~MemoryPool() noexcept {
-    slot_pointer_ curr = currentBlock_;
+template <typename T, size_t BlockSize, typename BlockProvider, size_t Alignment>
+MemoryPoolCore<T, BlockSize, BlockProvider, Alignment>::~MemoryPoolCore() noexcept {
+    // region 中最后一个区块释放时整个 region 还给 BlockProvider, 不需要逐个 madvise
+    block_pointer_ curr = blocks_;
     while (curr != nullptr) {
-        slot_pointer_ prev = curr->next;
-        ::operator delete(curr);
-        curr = prev;
+        block_pointer_ next = curr->next;
+        block_pointer_ region = curr->region;
+        if (--region->regionLive == 0)
+            provider_.deallocate(region, region->regionBlocks * BlockSize, BlockSize);
+        curr = next;
     }
 }
 
-#endif // MEMORY_POOL_HPP
\ No newline at end of file
+#endif // MEMORY_POOL_HPP
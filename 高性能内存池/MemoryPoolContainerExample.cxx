@@ -0,0 +1,144 @@
+// MemoryPool 作为标准容器分配器的示例: vector 按 n 个连续对象槽分配数组,
+// deque 和 unordered_map 用临时 rebind 的分配器分配内部数组, 与 std::allocator 的容器逐步对照
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryPool.hpp" // MemoryPool<T>
+
+// 随机操作的次数
+#define OPERATIONS 200000
+// key 的取值范围
+#define KEYS 5000
+
+typedef std::unordered_map<int, std::string, std::hash<int>, std::equal_to<int>, MemoryPool<std::pair<const int, std::string> > > PooledHashMap;
+typedef std::map<int, std::string, std::less<int>, MemoryPool<std::pair<const int, std::string> > > PooledMap;
+
+void report(const char* name, bool ok) {
+    std::cout << name << ": " << (ok ? "ok" : "FAILED") << "\n";
+}
+
+int main() {
+    bool ok = true;
+    std::mt19937 rng(45);
+
+    // vector 扩容时申请 n 个连续的对象槽, 旧数组按长度放入缓存, 下次同样长度的请求直接复用
+    {
+        std::vector<int, MemoryPool<int> > pooled;
+        std::vector<int> expected;
+        bool same = true;
+        for (int i = 0; i < OPERATIONS; i++) {
+            if (rng() % 4 != 0 || expected.empty()) {
+                pooled.push_back(i);
+                expected.push_back(i);
+            } else {
+                pooled.pop_back();
+                expected.pop_back();
+            }
+            if (i % 1000 == 0) {
+                // 收缩后重新增长, 会反复申请和释放各种长度的数组
+                pooled.shrink_to_fit();
+                same &= pooled.size() == expected.size() && std::equal(pooled.begin(), pooled.end(), expected.begin());
+            }
+        }
+        same &= std::equal(pooled.begin(), pooled.end(), expected.begin(), expected.end());
+        report("vector", same);
+        ok &= same;
+    }
+
+    // deque 的中控数组由临时 rebind 的 MemoryPool<int*> 分配和释放, 它们共享同一个内存池
+    {
+        std::deque<int, MemoryPool<int> > pooled;
+        std::deque<int> expected;
+        for (int i = 0; i < OPERATIONS; i++) {
+            switch (rng() % 4) {
+            case 0:
+                pooled.push_front(i);
+                expected.push_front(i);
+                break;
+            case 1:
+                pooled.push_back(i);
+                expected.push_back(i);
+                break;
+            case 2:
+                if (!expected.empty()) {
+                    pooled.pop_front();
+                    expected.pop_front();
+                }
+                break;
+            default:
+                if (!expected.empty()) {
+                    pooled.pop_back();
+                    expected.pop_back();
+                }
+                break;
+            }
+        }
+        std::deque<int, MemoryPool<int> > copy(pooled);
+        bool same = std::equal(pooled.begin(), pooled.end(), expected.begin(), expected.end());
+        same &= std::equal(copy.begin(), copy.end(), expected.begin(), expected.end());
+        report("deque", same);
+        ok &= same;
+    }
+
+    // unordered_map 的桶数组同样由临时 rebind 的分配器分配, 节点来自另一个对象类型的内存池
+    {
+        PooledHashMap pooled;
+        std::map<int, std::string> expected;
+        for (int i = 0; i < OPERATIONS; i++) {
+            int key = rng() % KEYS;
+            if (rng() % 3 != 0) {
+                pooled[key] = std::to_string(i);
+                expected[key] = std::to_string(i);
+            } else {
+                pooled.erase(key);
+                expected.erase(key);
+            }
+        }
+        pooled.rehash(4 * KEYS);
+        bool same = pooled.size() == expected.size();
+        for (std::map<int, std::string>::iterator it = expected.begin(); it != expected.end(); ++it) {
+            PooledHashMap::iterator found = pooled.find(it->first);
+            same &= found != pooled.end() && found->second == it->second;
+        }
+        report("unordered_map", same);
+        ok &= same;
+    }
+
+    // 节点式容器每次只分配一个对象槽
+    {
+        std::list<int, MemoryPool<int> > list;
+        PooledMap pooled;
+        std::map<int, std::string> expected;
+        for (int i = 0; i < OPERATIONS; i++) {
+            list.push_back(i);
+            int key = rng() % KEYS;
+            pooled[key] = std::to_string(i);
+            expected[key] = std::to_string(i);
+        }
+        bool same = list.size() == OPERATIONS && list.back() == OPERATIONS - 1;
+        same &= pooled.size() == expected.size() && std::equal(pooled.begin(), pooled.end(), expected.begin());
+        report("list, map", same);
+        ok &= same;
+    }
+
+    // rebind 得到的分配器共享同一组内存池, 所以相等, 并且可以释放对方分配的内存
+    {
+        MemoryPool<int> pool;
+        MemoryPool<double> rebound(pool);
+        MemoryPool<int> back(rebound);
+        int* p = back.allocate();
+        pool.deallocate(p);
+        bool same = pool == rebound && pool == back && pool != MemoryPool<int>();
+        report("rebind", same);
+        ok &= same;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
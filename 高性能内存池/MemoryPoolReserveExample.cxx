@@ -0,0 +1,113 @@
+// MemoryPool::reserve 和区块增长策略的示例: 用一个记录调用次数的 BlockProvider 检查
+// reserve(n) 之后的 n 次分配不再向 BlockProvider 申请内存, 以及每次申请的区块个数按 MemoryPoolGrowth 翻倍
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "MemoryPool.hpp" // MemoryPool<T>
+
+// 预留的对象个数
+#define RESERVED 100000
+// 区块大小
+#define BLOCK_SIZE 4096
+
+// 记录调用次数和申请的字节数的 BlockProvider, 内存池持有的是它的副本, 所以计数放在静态成员中
+class CountingBlockProvider {
+public:
+    static size_t allocations;
+    static size_t deallocations;
+    static std::vector<size_t> sizes;
+
+    void* allocate(size_t size, size_t alignment) {
+        allocations++;
+        sizes.push_back(size);
+        return provider_.allocate(size, alignment);
+    }
+    void deallocate(void* p, size_t size, size_t alignment) noexcept {
+        deallocations++;
+        provider_.deallocate(p, size, alignment);
+    }
+
+private:
+    NewBlockProvider provider_;
+};
+
+size_t CountingBlockProvider::allocations = 0;
+size_t CountingBlockProvider::deallocations = 0;
+std::vector<size_t> CountingBlockProvider::sizes;
+
+struct Order {
+    long id;
+    double price;
+    double quantity;
+};
+
+int main() {
+    bool ok = true;
+
+    {
+        // 每次申请的区块个数从 1 开始翻倍, 最多 8 个
+        MemoryPoolGrowth growth;
+        growth.initialBlocks = 1;
+        growth.maxBlocks = 8;
+        MemoryPool<Order, BLOCK_SIZE, CountingBlockProvider> pool;
+        pool.setGrowth(growth);
+
+        std::vector<Order*> orders;
+        for (long i = 0; i < RESERVED / 10; i++) {
+            orders.push_back(pool.allocate());
+            pool.construct(orders.back(), Order{i, 1.0, 2.0});
+        }
+        bool step = CountingBlockProvider::sizes.size() > 4;
+        for (size_t i = 0; i < CountingBlockProvider::sizes.size(); i++) {
+            size_t blocks = i < 3 ? (size_t(1) << i) : growth.maxBlocks;
+            step &= CountingBlockProvider::sizes[i] == blocks * BLOCK_SIZE;
+        }
+        std::cout << "growth: " << CountingBlockProvider::allocations << " provider calls for " << pool.blockCount() << " blocks, "
+                  << (step ? "ok" : "FAILED") << "\n";
+        ok &= step;
+
+        for (size_t i = 0; i < orders.size(); i++) {
+            pool.deallocate(orders[i]);
+        }
+    }
+    bool step = CountingBlockProvider::deallocations == CountingBlockProvider::allocations;
+    std::cout << "destroy: " << CountingBlockProvider::deallocations << " provider calls, " << (step ? "ok" : "FAILED") << "\n";
+    ok &= step;
+
+    {
+        // reserve 之后的 RESERVED 次分配都不需要再调用 BlockProvider
+        MemoryPool<Order, BLOCK_SIZE, CountingBlockProvider> pool;
+        pool.reserve(RESERVED, true);
+        size_t before = CountingBlockProvider::allocations;
+        size_t spare = pool.spareBlockCount();
+
+        std::vector<Order*> orders;
+        for (long i = 0; i < RESERVED; i++) {
+            orders.push_back(pool.allocate());
+            pool.construct(orders.back(), Order{i, 1.0, 2.0});
+        }
+        step = CountingBlockProvider::allocations == before && spare > 0;
+        for (long i = 0; i < RESERVED; i++) {
+            step &= orders[i]->id == i;
+        }
+        std::cout << "reserve(" << RESERVED << "): " << spare << " spare blocks, " << CountingBlockProvider::allocations - before
+                  << " provider calls while allocating, " << (step ? "ok" : "FAILED") << "\n";
+        ok &= step;
+
+        // 超出预留的个数之后按增长策略继续申请
+        orders.push_back(pool.allocate());
+        for (long i = 0; i < RESERVED; i++) {
+            orders.push_back(pool.allocate());
+        }
+        step = CountingBlockProvider::allocations > before;
+        std::cout << "beyond reserve: " << CountingBlockProvider::allocations - before << " provider calls, " << (step ? "ok" : "FAILED") << "\n";
+        ok &= step;
+
+        for (size_t i = 0; i < orders.size(); i++) {
+            pool.deallocate(orders[i]);
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
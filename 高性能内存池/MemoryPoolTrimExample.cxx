@@ -0,0 +1,123 @@
+// MemoryPool 归还空闲内存区块的示例: 释放大部分对象后 trim() 归还完全空闲的区块,
+// 以及用 MemoryPoolRetention 限制保留的空闲区块个数; 每一步都检查还在使用的对象没有被破坏
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "MemoryPool.hpp" // MemoryPool<T>
+
+// 分配的对象个数
+#define ELEMS 100000
+// 每隔多少个对象留下一个不释放
+#define KEEP_EVERY 500
+
+struct Item {
+    long id;
+    long payload[3];
+};
+
+void report(const char* step, const MemoryPool<Item>& pool, bool ok) {
+    std::cout << step << ": " << pool.blockCount() << " blocks, " << pool.emptyBlockCount() << " empty, " << (ok ? "ok" : "FAILED") << "\n";
+}
+
+bool intact(const std::vector<Item*>& items) {
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i] != nullptr && (items[i]->payload[0] != items[i]->id || items[i]->payload[2] != -items[i]->id))
+            return false;
+    }
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    std::mt19937 rng(46);
+    MemoryPool<Item> pool;
+
+    std::vector<Item*> items;
+    for (long i = 0; i < ELEMS; i++) {
+        Item* item = pool.allocate();
+        pool.construct(item, Item{i, {i, 0, -i}});
+        items.push_back(item);
+    }
+    size_t allocated = pool.blockCount();
+    report("allocate", pool, intact(items));
+
+    // 按随机顺序释放, 只留下少数对象, 大部分区块变成完全空闲
+    std::vector<size_t> order;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i % KEEP_EVERY != 0)
+            order.push_back(i);
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    for (size_t i = 0; i < order.size(); i++) {
+        pool.deallocate(items[order[i]]);
+        items[order[i]] = nullptr;
+    }
+    bool step = pool.blockCount() == allocated && pool.emptyBlockCount() > 0 && intact(items);
+    report("deallocate", pool, step);
+    ok &= step;
+
+    // trim() 只归还完全空闲的区块, 留下的对象不受影响
+    size_t empty = pool.emptyBlockCount();
+    size_t released = pool.trim();
+    step = released >= empty && pool.emptyBlockCount() == 0 && pool.blockCount() == allocated - released && intact(items);
+    report("trim", pool, step);
+    ok &= step;
+
+    // 归还之后可以继续分配
+    for (size_t i = 0; i < order.size(); i += 2) {
+        long id = order[i];
+        items[id] = pool.allocate();
+        pool.construct(items[id], Item{id, {id, 0, -id}});
+    }
+    step = intact(items);
+    report("reallocate", pool, step);
+    ok &= step;
+
+    // 全部释放之后 trim() 归还所有区块
+    for (size_t i = 0; i < items.size(); i++) {
+        if (items[i] != nullptr)
+            pool.deallocate(items[i]);
+    }
+    pool.trim();
+    step = pool.blockCount() == 0 && pool.emptyBlockCount() == 0;
+    report("trim all", pool, step);
+    ok &= step;
+
+    // 最多保留 4 个完全空闲的区块, 超出的在释放时立即归还, 不需要调用 trim()
+    MemoryPoolRetention retention;
+    retention.maxEmptyBlocks = 4;
+    pool.setRetention(retention);
+    items.clear();
+    for (long i = 0; i < ELEMS; i++) {
+        items.push_back(pool.allocate());
+        pool.construct(items.back(), Item{i, {i, 0, -i}});
+    }
+    for (size_t i = 0; i < items.size(); i++) {
+        pool.deallocate(items[i]);
+    }
+    step = pool.emptyBlockCount() <= retention.maxEmptyBlocks;
+    report("maxEmptyBlocks = 4", pool, step);
+    ok &= step;
+
+    // adviseOnly: 空闲区块只归还物理内存, 地址空间留给之后的分配复用
+    retention.maxEmptyBlocks = 0;
+    retention.adviseOnly = true;
+    pool.setRetention(retention);
+    items.clear();
+    for (long i = 0; i < ELEMS; i++) {
+        items.push_back(pool.allocate());
+        pool.construct(items.back(), Item{i, {i, 0, -i}});
+    }
+    step = intact(items);
+    for (size_t i = 0; i < items.size(); i++) {
+        pool.deallocate(items[i]);
+    }
+    step &= pool.emptyBlockCount() == 0;
+    report("adviseOnly", pool, step);
+    ok &= step;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
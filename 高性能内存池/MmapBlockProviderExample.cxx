@@ -0,0 +1,71 @@
+// MmapBlockProvider 的示例: MemoryPool 的内存区块从 mmap 的 2MB slab 中切出,
+// 释放对象并 trim() 之后, slab 被 munmap, 内存真正还给系统
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "BlockProvider.hpp" // MmapBlockProvider
+#include "MemoryPool.hpp"    // MemoryPool<T, BlockSize, BlockProvider>
+
+// 分配的对象个数
+#define ELEMS 1000000
+
+// 当前进程的常驻内存 (KB), 读不到时为 0
+long residentKB() {
+    long pages = 0, resident = 0;
+    if (FILE* file = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(file, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        std::fclose(file);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main() {
+    bool ok = true;
+
+    MmapBlockOptions options;
+    // 透明大页只是建议, 系统不支持时仍然使用普通页
+    options.hugePages = true;
+    MemoryPool<long, 4096, MmapBlockProvider> pool{MmapBlockProvider(options)};
+
+    std::vector<long*> items;
+    for (long i = 0; i < ELEMS; i++) {
+        items.push_back(pool.allocate());
+        *items.back() = i;
+    }
+    std::cout << "allocated: " << pool.blockCount() << " blocks, " << pool.provider().mappedBytes() / 1024 << "KB mapped, "
+              << residentKB() << "KB resident\n";
+
+    // 释放一半的对象: 每个用过的区块都还有对象在使用, 只有还没用过的备用区块可以归还
+    for (long i = 0; i < ELEMS; i += 2) {
+        pool.deallocate(items[i]);
+    }
+    std::cout << "trim() after freeing every other object: " << pool.trim() << " blocks returned\n";
+
+    for (long i = 1; i < ELEMS; i += 2) {
+        ok &= *items[i] == i;
+        pool.deallocate(items[i]);
+    }
+    size_t returned = pool.trim();
+    std::cout << "trim() after freeing everything: " << returned << " blocks returned, " << pool.provider().mappedBytes() / 1024
+              << "KB mapped, " << residentKB() << "KB resident\n";
+    ok &= pool.blockCount() == 0 && pool.provider().mappedBytes() == 0;
+
+    // 只保留 4 个完全空闲的区块, 其余的在释放时立即归还
+    MemoryPoolRetention retention;
+    retention.maxEmptyBlocks = 4;
+    pool.setRetention(retention);
+    for (long i = 0; i < ELEMS; i++) {
+        items[i] = pool.allocate();
+    }
+    for (long i = 0; i < ELEMS; i++) {
+        pool.deallocate(items[i]);
+    }
+    std::cout << "maxEmptyBlocks = 4: " << pool.blockCount() << " blocks kept, " << pool.emptyBlockCount() << " empty, "
+              << pool.spareBlockCount() << " spare\n";
+    ok &= pool.emptyBlockCount() <= 4;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,304 @@
+#ifndef NUMA_MEMORY_POOL_HPP
+#define NUMA_MEMORY_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "BlockProvider.hpp"
+#include "MemoryPool.hpp"
+
+// 系统中 NUMA 节点的个数, 读取 /sys/devices/system/node/possible ("0" 或 "0-1" 这样的格式), 读不到时为 1
+inline size_t numaNodeCount() {
+    static const size_t count = [] {
+        size_t last = 0;
+        if (FILE* file = std::fopen("/sys/devices/system/node/possible", "r")) {
+            unsigned long first = 0, second = 0;
+            int matched = std::fscanf(file, "%lu-%lu", &first, &second);
+            if (matched == 2)
+                last = second;
+            else if (matched == 1)
+                last = first;
+            std::fclose(file);
+        }
+        return last + 1;
+    }();
+    return count;
+}
+
+// 当前线程所在 CPU 的 NUMA 节点, 不支持时为 0
+inline size_t currentNumaNode() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    unsigned cpu = 0, node = 0;
+    if (getcpu(&cpu, &node) == 0)
+        return node;
+#elif defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+        return node;
+#endif
+    return 0;
+}
+
+// 每个 NUMA 节点的统计
+struct NumaNodeStats {
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    // 在其他节点的 CPU 上释放的次数
+    size_t remoteDeallocations = 0;
+    // 持有的内存区块个数和映射的字节数
+    size_t blocks = 0;
+    size_t mappedBytes = 0;
+};
+
+// 多线程共享的 NUMA 感知内存池: 每个节点一个 arena (一个加锁的 MemoryPool),
+// arena 的内存用 mbind 优先放在对应的节点上, 分配时使用当前线程所在节点的 arena.
+// 内存按 slab 映射, 每个 slab 只属于一个 arena, 释放时由地址查表找到所属的 arena, 可以在任意线程释放.
+// 单节点的机器上只有一个 arena; 也可以指定 arena 个数, 在单节点的机器上测试多节点的行为.
+// 这是对象池而不是标准库的分配器: 不能复制, 没有 rebind, 每次只分配一个对象
+template <typename T, size_t BlockSize = 4096>
+class NumaMemoryPool {
+public:
+    explicit NumaMemoryPool(size_t nodeCount = numaNodeCount());
+
+    NumaMemoryPool(const NumaMemoryPool&) = delete;
+    NumaMemoryPool& operator=(const NumaMemoryPool&) = delete;
+
+    // 从当前线程所在节点的 arena 分配一个对象, n 不为 1 时抛出 std::bad_alloc; hint 会被忽略
+    T* allocate(size_t n = 1, const T* /*hint*/ = 0) {
+        if (n != 1)
+            throw std::bad_alloc();
+        return allocateOnNode(currentNumaNode());
+    }
+    // 从指定节点的 arena 分配
+    T* allocateOnNode(size_t node);
+
+    // 调用构造函数
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    // 可以在任意线程释放, n 只能是 1; p 不是这个内存池分配的时抛出 std::invalid_argument
+    void deallocate(T* p, size_t n = 1);
+
+    template <typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+    size_t nodeCount() const {
+        return arenas_.size();
+    }
+    // node 超出 nodeCount() 时抛出 std::out_of_range
+    NumaNodeStats stats(size_t node) const;
+
+private:
+    static constexpr size_t log2_(size_t n) {
+        return n <= 1 ? 0 : 1 + log2_(n / 2);
+    }
+
+    // slab 的大小, 同时是地址表的粒度
+    static const size_t slabShift_ = log2_(BlockSize > (size_t(2) << 20) ? BlockSize : (size_t(2) << 20));
+    // 地址表分两级, 覆盖 48 位的用户态地址空间
+    static const size_t leafBits_ = 14;
+    static const size_t rootBits_ = 48 - slabShift_ - leafBits_;
+
+    // slab -> arena 编号 + 1 (0 表示未知)
+    struct PageMap_ {
+        std::atomic<std::atomic<uint16_t>*> leaves[size_t(1) << rootBits_] = {};
+
+        ~PageMap_() {
+            for (size_t i = 0; i < (size_t(1) << rootBits_); i++) {
+                delete[] leaves[i].load(std::memory_order_relaxed);
+            }
+        }
+        // 查找 p 所在 slab 的 arena
+        uint16_t get(const void* p) const {
+            uintptr_t slab = reinterpret_cast<uintptr_t>(p) >> slabShift_;
+            std::atomic<uint16_t>* leaf = leaves[(slab >> leafBits_) & ((size_t(1) << rootBits_) - 1)].load(std::memory_order_acquire);
+            return leaf != nullptr ? leaf[slab & ((size_t(1) << leafBits_) - 1)].load(std::memory_order_relaxed) : 0;
+        }
+        // 登记 [p, p + size) 覆盖的 slab, tag 为 0 时清除登记
+        void set(const void* p, size_t size, uint16_t tag);
+    };
+
+    // 给 arena 的 MemoryPool 提供内存区块, 同时在地址表中登记和清除它们所在的 slab.
+    // 地址表按 slab 登记, 所以一个 slab 只能属于一个 arena: 小的请求从 MmapBlockProvider 的 slab 中切出,
+    // slab 中第一个区块分配时登记, 最后一个区块释放 (MmapBlockProvider 随即 munmap 整个 slab) 之前清除;
+    // 单独映射的大请求按 slab 对齐并补齐到整数个 slab, 不会与其他 arena 的映射落在同一个 slab 中
+    class ArenaProvider_ {
+    public:
+        ArenaProvider_(const MmapBlockOptions& options, PageMap_* map, uint16_t tag)
+            : provider_(options), map_(map), tag_(tag) {
+        }
+
+        void* allocate(size_t size, size_t alignment) {
+            if (large_(size, alignment)) {
+                size = slabRound_(size);
+                void* p = provider_.allocate(size, alignment > slabSize_ ? alignment : slabSize_);
+                map_->set(p, size, tag_);
+                return p;
+            }
+
+            void* p = provider_.allocate(size, alignment);
+            try {
+                if (live_[slabOf_(p)]++ == 0)
+                    map_->set(p, size, tag_);
+            } catch (...) {
+                provider_.deallocate(p, size, alignment);
+                throw;
+            }
+            return p;
+        }
+        void deallocate(void* p, size_t size, size_t alignment) noexcept {
+            // 先清除登记再 munmap, 否则其他 arena 可能在这之间映射到同一个地址并被清除登记
+            if (large_(size, alignment)) {
+                size = slabRound_(size);
+                map_->set(p, size, 0);
+                provider_.deallocate(p, size, alignment > slabSize_ ? alignment : slabSize_);
+                return;
+            }
+
+            std::unordered_map<uintptr_t, size_t>::iterator it = live_.find(slabOf_(p));
+            if (it != live_.end() && --it->second == 0) {
+                live_.erase(it);
+                map_->set(p, 1, 0);
+            }
+            provider_.deallocate(p, size, alignment);
+        }
+        size_t mappedBytes() const {
+            return provider_.mappedBytes();
+        }
+
+    private:
+        static const size_t slabSize_ = size_t(1) << slabShift_;
+
+        MmapBlockProvider provider_;
+        PageMap_* map_;
+        uint16_t tag_;
+        // slab -> 其中正在使用的区块个数, 与 MmapBlockProvider 决定何时 munmap slab 的计数一致
+        std::unordered_map<uintptr_t, size_t> live_;
+
+        // 与 MmapBlockProvider 相同的判断: 超过 slab 一半的请求单独映射
+        static bool large_(size_t size, size_t alignment) {
+            return size > slabSize_ / 2 || alignment > slabSize_;
+        }
+        static size_t slabRound_(size_t size) {
+            return (size + slabSize_ - 1) & ~(slabSize_ - 1);
+        }
+        static uintptr_t slabOf_(const void* p) {
+            return reinterpret_cast<uintptr_t>(p) >> slabShift_;
+        }
+    };
+
+    struct alignas(64) Arena_ {
+        explicit Arena_(const ArenaProvider_& provider)
+            : pool(provider) {
+        }
+
+        std::mutex mutex;
+        MemoryPool<T, BlockSize, ArenaProvider_> pool;
+        NumaNodeStats stats;
+    };
+
+    // arena 持有的内存先于地址表释放, 所以 map_ 要声明在 arenas_ 之前
+    std::unique_ptr<PageMap_> map_;
+    std::vector<std::unique_ptr<Arena_>> arenas_;
+
+    static_assert(BlockSize <= (size_t(1) << 34), "BlockSize is too large.");
+};
+
+template <typename T, size_t BlockSize>
+void NumaMemoryPool<T, BlockSize>::PageMap_::set(const void* p, size_t size, uint16_t tag) {
+    uintptr_t first = reinterpret_cast<uintptr_t>(p) >> slabShift_;
+    uintptr_t last = (reinterpret_cast<uintptr_t>(p) + size - 1) >> slabShift_;
+    for (uintptr_t slab = first; slab <= last; slab++) {
+        std::atomic<std::atomic<uint16_t>*>& entry = leaves[(slab >> leafBits_) & ((size_t(1) << rootBits_) - 1)];
+        std::atomic<uint16_t>* leaf = entry.load(std::memory_order_acquire);
+        if (leaf == nullptr) {
+            // 多个 arena 可能同时创建同一个叶子, 只保留先成功的那个
+            std::atomic<uint16_t>* created = new std::atomic<uint16_t>[size_t(1) << leafBits_]();
+            if (entry.compare_exchange_strong(leaf, created, std::memory_order_acq_rel, std::memory_order_acquire))
+                leaf = created;
+            else
+                delete[] created;
+        }
+        leaf[slab & ((size_t(1) << leafBits_) - 1)].store(tag, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, size_t BlockSize>
+NumaMemoryPool<T, BlockSize>::NumaMemoryPool(size_t nodeCount)
+    : map_(new PageMap_) {
+    if (nodeCount == 0)
+        nodeCount = 1;
+    if (nodeCount > UINT16_MAX - 1)
+        nodeCount = UINT16_MAX - 1;
+
+    arenas_.reserve(nodeCount);
+    for (size_t node = 0; node < nodeCount; node++) {
+        MmapBlockOptions options;
+        options.slabSize = size_t(1) << slabShift_;
+        options.numaNode = static_cast<int>(node);
+        arenas_.emplace_back(new Arena_(ArenaProvider_(options, map_.get(), static_cast<uint16_t>(node + 1))));
+    }
+}
+
+template <typename T, size_t BlockSize>
+T* NumaMemoryPool<T, BlockSize>::allocateOnNode(size_t node) {
+    Arena_& arena = *arenas_[node % arenas_.size()];
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    T* p = arena.pool.allocate();
+    arena.stats.allocations++;
+    return p;
+}
+
+template <typename T, size_t BlockSize>
+void NumaMemoryPool<T, BlockSize>::deallocate(T* p, size_t /*n*/) {
+    if (p == nullptr)
+        return;
+
+    // 地址表中没有登记的 slab 不属于任何 arena
+    size_t tag = map_->get(p);
+    if (tag == 0 || tag > arenas_.size())
+        throw std::invalid_argument("NumaMemoryPool: pointer was not allocated by this pool");
+
+    size_t index = tag - 1;
+    Arena_& arena = *arenas_[index];
+    bool remote = currentNumaNode() % arenas_.size() != index;
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    arena.pool.deallocate(p);
+    arena.stats.deallocations++;
+    if (remote)
+        arena.stats.remoteDeallocations++;
+}
+
+template <typename T, size_t BlockSize>
+NumaNodeStats NumaMemoryPool<T, BlockSize>::stats(size_t node) const {
+    if (node >= arenas_.size())
+        throw std::out_of_range("NumaMemoryPool: node out of range");
+
+    Arena_& arena = *arenas_[node];
+    std::lock_guard<std::mutex> lock(arena.mutex);
+    NumaNodeStats result = arena.stats;
+    result.blocks = arena.pool.blockCount();
+    result.mappedBytes = arena.pool.provider().mappedBytes();
+    return result;
+}
+
+#endif // NUMA_MEMORY_POOL_HPP
@@ -0,0 +1,87 @@
+// NumaMemoryPool 的示例: 每个线程从自己所在节点的 arena 分配, 对象可以在任意线程释放.
+// 单节点的机器上可以用参数指定 arena 个数, 模拟多节点的行为
+//
+// 用法: NumaMemoryPoolExample [nodes]
+//     nodes  arena 个数, 默认为系统中的 NUMA 节点个数
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "NumaMemoryPool.hpp" // NumaMemoryPool<T>
+
+// 每个线程分配的对象个数
+#define ELEMS 100000
+
+int main(int argc, char** argv) {
+    size_t nodes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : numaNodeCount();
+    NumaMemoryPool<long> pool(nodes);
+    std::cout << "NUMA nodes: " << numaNodeCount() << ", arenas: " << pool.nodeCount() << ", current node: " << currentNumaNode() << "\n";
+
+    // 每个 arena 一个线程, 从指定的 arena 分配, 交给下一个线程释放 (跨节点释放)
+    std::vector<std::vector<long*>> allocated(pool.nodeCount());
+    std::vector<std::thread> threads;
+    for (size_t node = 0; node < pool.nodeCount(); node++) {
+        threads.push_back(std::thread([&, node] {
+            for (long i = 0; i < ELEMS; i++) {
+                long* p = pool.allocateOnNode(node);
+                *p = i;
+                allocated[node].push_back(p);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    threads.clear();
+
+    long errors = 0;
+    std::mutex errorsMutex;
+    for (size_t node = 0; node < pool.nodeCount(); node++) {
+        threads.push_back(std::thread([&, node] {
+            std::vector<long*>& items = allocated[(node + 1) % pool.nodeCount()];
+            long bad = 0;
+            for (long i = 0; i < ELEMS; i++) {
+                if (*items[i] != i)
+                    bad++;
+                pool.deallocate(items[i]);
+            }
+            std::lock_guard<std::mutex> lock(errorsMutex);
+            errors += bad;
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+
+    for (size_t node = 0; node < pool.nodeCount(); node++) {
+        NumaNodeStats stats = pool.stats(node);
+        std::cout << "arena " << node << ": " << stats.allocations << " allocations, " << stats.deallocations << " deallocations ("
+                  << stats.remoteDeallocations << " remote), " << stats.blocks << " blocks, " << stats.mappedBytes / 1024 << "KB mapped\n";
+        if (stats.allocations != ELEMS || stats.deallocations != ELEMS)
+            errors++;
+    }
+
+    // 不是这个内存池分配的指针会被拒绝
+    long local = 0;
+    try {
+        pool.deallocate(&local);
+        errors++;
+    } catch (const std::invalid_argument& e) {
+        std::cout << "foreign pointer: " << e.what() << "\n";
+    }
+
+    // 每次只能分配一个对象
+    try {
+        pool.allocate(2);
+        errors++;
+    } catch (const std::bad_alloc&) {
+        std::cout << "allocate(2): rejected\n";
+    }
+
+    std::cout << errors << " errors\n";
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,125 @@
+#ifndef POOL_RESOURCE_HPP
+#define POOL_RESOURCE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <tuple>
+#include <utility>
+
+#include "MemoryPool.hpp"
+
+// 按大小分级的 std::pmr::memory_resource: 8 ~ 4096 字节的请求按 1.5 倍左右的间隔分为 17 级,
+// 每一级由一个 MemoryPool 提供内存, 对齐要求超过所在级别的对齐时使用满足对齐的更大的级别,
+// 更大的请求或者对齐要求超过 4096 字节时交给 upstream.
+// 可以用于任何 std::pmr 容器:
+//     PoolResource resource;
+//     std::pmr::vector<std::pmr::string> v(&resource);
+// 与 MemoryPool 一样不是线程安全的, 内存在 PoolResource 析构时统一释放.
+// 每一级的内存池各自使用一个默认构造的 BlockProvider
+template <size_t BlockSize = 65536, typename BlockProvider = NewBlockProvider>
+class PoolResource : public std::pmr::memory_resource {
+public:
+    explicit PoolResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream) {
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const {
+        return upstream_;
+    }
+
+    // 能够由内存池提供的最大请求
+    static constexpr size_t maxPooledSize = 4096;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    // 各级的大小
+    static constexpr std::array<size_t, 17> classSizes_ = {8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 4096};
+
+    // 每一级按大小的最低位对齐, 例如 48 字节的级别按 16 字节对齐, 4096 字节的级别按 4096 字节对齐
+    static constexpr size_t classAlignment_(size_t size) {
+        return size & (0 - size);
+    }
+
+    // N 字节的内存块, 作为 MemoryPool 的对象类型
+    template <size_t N>
+    struct alignas(classAlignment_(N)) Chunk_ {
+        unsigned char data[N];
+    };
+
+    template <typename Indices>
+    struct Pools_;
+    template <size_t... I>
+    struct Pools_<std::index_sequence<I...>> {
+        using type = std::tuple<MemoryPool<Chunk_<classSizes_[I]>, BlockSize, BlockProvider>...>;
+    };
+    using pools_type_ = typename Pools_<std::make_index_sequence<classSizes_.size()>>::type;
+    using indices_ = std::make_index_sequence<classSizes_.size()>;
+
+    // 请求大小 (按 8 字节向上取整后除以 8) -> 级别
+    static constexpr std::array<uint8_t, maxPooledSize / 8 + 1> classIndex_ = [] {
+        std::array<uint8_t, maxPooledSize / 8 + 1> table{};
+        size_t index = 0;
+        for (size_t i = 0; i < table.size(); i++) {
+            while (classSizes_[index] < i * 8)
+                index++;
+            table[i] = index;
+        }
+        return table;
+    }();
+
+    std::pmr::memory_resource* upstream_;
+    pools_type_ pools_;
+
+    // 请求对应的级别: 先按大小查表, 对齐要求更大时向上找第一个满足对齐的级别; 没有时返回级别的个数
+    static size_t classFor_(size_t bytes, size_t alignment) {
+        if (bytes > maxPooledSize)
+            return classSizes_.size();
+        size_t index = classIndex_[(bytes + 7) / 8];
+        while (index < classSizes_.size() && classAlignment_(classSizes_[index]) < alignment)
+            index++;
+        return index;
+    }
+
+    template <size_t... I>
+    void* allocateFrom_(size_t index, std::index_sequence<I...>) {
+        void* result = nullptr;
+        ((index == I && (result = std::get<I>(pools_).allocate(), true)) || ...);
+        return result;
+    }
+    template <size_t... I>
+    void deallocateTo_(size_t index, void* p, std::index_sequence<I...>) {
+        ((index == I && (std::get<I>(pools_).deallocate(static_cast<Chunk_<classSizes_[I]>*>(p)), true)) || ...);
+    }
+
+    static_assert(BlockSize >= 3 * maxPooledSize, "BlockSize is too small.");
+};
+
+template <size_t BlockSize, typename BlockProvider>
+void* PoolResource<BlockSize, BlockProvider>::do_allocate(size_t bytes, size_t alignment) {
+    size_t index = classFor_(bytes, alignment);
+    if (index == classSizes_.size())
+        return upstream_->allocate(bytes, alignment);
+    return allocateFrom_(index, indices_());
+}
+
+template <size_t BlockSize, typename BlockProvider>
+void PoolResource<BlockSize, BlockProvider>::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    size_t index = classFor_(bytes, alignment);
+    if (index == classSizes_.size())
+        upstream_->deallocate(p, bytes, alignment);
+    else
+        deallocateTo_(index, p, indices_());
+}
+
+#endif // POOL_RESOURCE_HPP
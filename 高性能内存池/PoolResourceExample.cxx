@@ -0,0 +1,70 @@
+// PoolResource 的示例: 作为 std::pmr 容器的内存来源, 小的请求由各级内存池提供,
+// 超过 maxPooledSize 的请求交给 upstream
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "PoolResource.hpp" // PoolResource<BlockSize>
+
+// 记录经过 upstream 的请求个数
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t outstanding = 0;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocations++;
+        outstanding++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        outstanding--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+int main() {
+    bool ok = true;
+    CountingResource upstream;
+    {
+        PoolResource<> resource(&upstream);
+
+        // 字符串和 map 的节点都是小请求, 不经过 upstream
+        std::pmr::map<int, std::pmr::string> names(&resource);
+        for (int i = 0; i < 10000; i++) {
+            names.emplace(i, "name of a fairly long key number " + std::to_string(i));
+        }
+        for (int i = 0; i < 10000; i += 2) {
+            names.erase(i);
+        }
+        ok &= names.size() == 5000 && names[1] == "name of a fairly long key number 1";
+        std::cout << "pmr::map: " << names.size() << " entries, " << upstream.allocations << " upstream allocations\n";
+        ok &= upstream.allocations == 0;
+
+        // 对齐要求大于所在级别时使用更大的级别, 返回的地址仍然满足对齐
+        void* aligned = resource.allocate(24, 64);
+        ok &= reinterpret_cast<uintptr_t>(aligned) % 64 == 0;
+        resource.deallocate(aligned, 24, 64);
+        std::cout << "24 bytes aligned to 64: " << (ok ? "ok" : "FAILED") << "\n";
+
+        // vector 增长到超过 maxPooledSize 之后由 upstream 提供
+        std::pmr::vector<int> numbers(&resource);
+        for (int i = 0; i < 100000; i++) {
+            numbers.push_back(i);
+        }
+        ok &= numbers[99999] == 99999 && upstream.allocations > 0;
+        std::cout << "pmr::vector: " << upstream.allocations << " upstream allocations\n";
+    }
+    ok &= upstream.outstanding == 0;
+    std::cout << "upstream outstanding after destruction: " << upstream.outstanding << "\n";
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,203 @@
+#ifndef REMOTE_FREE_MEMORY_POOL_HPP
+#define REMOTE_FREE_MEMORY_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ThreadCache.hpp"
+
+// 每个线程拥有自己的堆 (内存区块和空闲链表), 分配和本线程的释放都不加锁也不用原子操作.
+// 内存区块按 BlockSize 对齐, 区块头部记录所属的堆, 释放时由地址直接找到它.
+// 其他线程释放的对象槽压入所属堆的远程释放栈 (多生产者单消费者),
+// 所属线程在本地空闲链表用完时一次取走整个栈, 对象槽始终回到分配它的线程.
+// 线程退出后它的堆成为孤儿, 之后新线程第一次分配时会接管它.
+// 这是对象池而不是标准库的分配器: 不能复制, 没有 rebind, 每次只分配一个对象
+template <typename T, size_t BlockSize = 4096>
+class RemoteFreeMemoryPool final : private ThreadCacheOwner {
+public:
+    RemoteFreeMemoryPool()
+        : id_(ThreadCacheRegistry::attach(this)) {
+    }
+    ~RemoteFreeMemoryPool() noexcept;
+
+    RemoteFreeMemoryPool(const RemoteFreeMemoryPool&) = delete;
+    RemoteFreeMemoryPool& operator=(const RemoteFreeMemoryPool&) = delete;
+
+    // 分配一个对象, n 不为 1 时抛出 std::bad_alloc; hint 会被忽略
+    T* allocate(size_t n = 1, const T* hint = 0);
+
+    // 调用构造函数
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    // 可以在任意线程释放; n 只能是 1
+    void deallocate(T* p, size_t n = 1);
+
+    template <typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+private:
+    union Slot_ {
+        T element;
+        Slot_* next;
+    };
+
+    using data_pointer_ = char*;
+    using slot_type_ = Slot_;
+    using slot_pointer_ = Slot_*;
+
+    struct Heap_;
+
+    // 内存区块头部
+    struct BlockHeader_ {
+        Heap_* owner;
+        BlockHeader_* next;
+    };
+
+    struct Heap_ {
+        // 本线程释放的对象槽
+        slot_pointer_ freeSlots{nullptr};
+        slot_pointer_ currentSlot{nullptr};
+        slot_pointer_ lastSlot{nullptr};
+        BlockHeader_* blocks{nullptr};
+        // 其他线程释放的对象槽
+        std::atomic<slot_pointer_> remoteFree{nullptr};
+    };
+
+    static const size_t bodyOffset_ = (sizeof(BlockHeader_) + alignof(slot_type_) - 1) / alignof(slot_type_) * alignof(slot_type_);
+
+    uint64_t id_;
+    // 保护 heaps_ 和 orphans_
+    std::mutex mutex_;
+    // 所有的堆, 在析构时统一释放
+    std::vector<Heap_*> heaps_;
+    // 线程已经退出, 等待接管的堆
+    std::vector<Heap_*> orphans_;
+
+    Heap_* localHeap_();
+    void allocateBlock_(Heap_* heap);
+    void threadExit(void* heap) noexcept override;
+
+    static Heap_* owner_(const void* p) {
+        uintptr_t block = reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(BlockSize - 1);
+        return reinterpret_cast<BlockHeader_*>(block)->owner;
+    }
+
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two.");
+    static_assert(BlockSize >= bodyOffset_ + 2 * sizeof(slot_type_), "BlockSize is too small.");
+};
+
+template <typename T, size_t BlockSize>
+RemoteFreeMemoryPool<T, BlockSize>::~RemoteFreeMemoryPool() noexcept {
+    ThreadCacheRegistry::detach(id_);
+    for (size_t i = 0; i < heaps_.size(); i++) {
+        BlockHeader_* curr = heaps_[i]->blocks;
+        while (curr != nullptr) {
+            BlockHeader_* next = curr->next;
+            ::operator delete(curr, std::align_val_t(BlockSize));
+            curr = next;
+        }
+        delete heaps_[i];
+    }
+}
+
+template <typename T, size_t BlockSize>
+T* RemoteFreeMemoryPool<T, BlockSize>::allocate(size_t n, const T* /*hint*/) {
+    if (n != 1)
+        throw std::bad_alloc();
+
+    Heap_* heap = localHeap_();
+
+    if (heap->freeSlots == nullptr) {
+        // 本地空闲链表用完, 一次取走其他线程释放的所有对象槽
+        if (heap->remoteFree.load(std::memory_order_relaxed) != nullptr)
+            heap->freeSlots = heap->remoteFree.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    if (heap->freeSlots != nullptr) {
+        slot_pointer_ result = heap->freeSlots;
+        heap->freeSlots = result->next;
+        return reinterpret_cast<T*>(result);
+    }
+
+    if (heap->currentSlot >= heap->lastSlot)
+        allocateBlock_(heap);
+    return reinterpret_cast<T*>(heap->currentSlot++);
+}
+
+template <typename T, size_t BlockSize>
+void RemoteFreeMemoryPool<T, BlockSize>::deallocate(T* p, size_t /*n*/) {
+    if (p == nullptr)
+        return;
+
+    slot_pointer_ slot = reinterpret_cast<slot_pointer_>(p);
+    Heap_* owner = owner_(p);
+
+    if (owner == ThreadCacheRegistry::get(id_)) {
+        slot->next = owner->freeSlots;
+        owner->freeSlots = slot;
+        return;
+    }
+
+    // 只有所属线程会取走整个栈 (exchange), 不会单独弹出栈顶, 所以压栈没有 ABA 问题
+    slot_pointer_ head = owner->remoteFree.load(std::memory_order_relaxed);
+    do {
+        slot->next = head;
+    } while (!owner->remoteFree.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// 当前线程的堆, 第一次使用时优先接管孤儿堆
+template <typename T, size_t BlockSize>
+typename RemoteFreeMemoryPool<T, BlockSize>::Heap_* RemoteFreeMemoryPool<T, BlockSize>::localHeap_() {
+    Heap_* heap = static_cast<Heap_*>(ThreadCacheRegistry::get(id_));
+    if (heap != nullptr)
+        return heap;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!orphans_.empty()) {
+            heap = orphans_.back();
+            orphans_.pop_back();
+        } else {
+            heap = new Heap_;
+            heaps_.push_back(heap);
+            // threadExit() 不能抛出异常, 预先留好位置
+            orphans_.reserve(heaps_.size());
+        }
+    }
+
+    ThreadCacheRegistry::set(id_, heap);
+    return heap;
+}
+
+template <typename T, size_t BlockSize>
+void RemoteFreeMemoryPool<T, BlockSize>::allocateBlock_(Heap_* heap) {
+    data_pointer_ newBlock = (data_pointer_)(operator new(BlockSize, std::align_val_t(BlockSize)));
+
+    BlockHeader_* header = reinterpret_cast<BlockHeader_*>(newBlock);
+    header->owner = heap;
+    header->next = heap->blocks;
+    heap->blocks = header;
+
+    size_t slotCount = (BlockSize - bodyOffset_) / sizeof(slot_type_);
+    heap->currentSlot = reinterpret_cast<slot_pointer_>(newBlock + bodyOffset_);
+    heap->lastSlot = heap->currentSlot + slotCount;
+}
+
+// 线程退出: 堆连同其中的空闲对象槽留给之后的线程接管
+template <typename T, size_t BlockSize>
+void RemoteFreeMemoryPool<T, BlockSize>::threadExit(void* heap) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    orphans_.push_back(static_cast<Heap_*>(heap));
+}
+
+#endif // REMOTE_FREE_MEMORY_POOL_HPP
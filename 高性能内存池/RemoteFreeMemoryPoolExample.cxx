@@ -0,0 +1,105 @@
+// RemoteFreeMemoryPool 的示例: 生产者线程分配消息, 交给消费者线程释放 (远程释放),
+// 对象槽回到生产者的堆中复用; 生产者退出后, 它的堆由之后的新线程接管
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "RemoteFreeMemoryPool.hpp" // RemoteFreeMemoryPool<T>
+
+// 生产者线程个数
+#define PRODUCERS 3
+// 每个生产者发送的消息个数
+#define MESSAGES 100000
+
+struct Message {
+    int producer;
+    int sequence;
+};
+
+int main() {
+    bool ok = true;
+
+    // 每次只能分配一个对象, 要求连续的多个对象时抛出 std::bad_alloc
+    RemoteFreeMemoryPool<Message> pool;
+    try {
+        pool.allocate(2);
+        ok = false;
+    } catch (const std::bad_alloc&) {
+    }
+    std::cout << "allocate(2): " << (ok ? "rejected" : "FAILED") << "\n";
+
+    std::deque<Message*> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueCond;
+    int finished = 0;
+
+    // 消费者检查每个生产者的消息按顺序到达, 然后在自己的线程中释放
+    long errors = 0;
+    std::thread consumer([&] {
+        std::vector<int> next(PRODUCERS, 0);
+        std::unique_lock<std::mutex> lock(queueMutex);
+        for (;;) {
+            queueCond.wait(lock, [&] { return !queue.empty() || finished == PRODUCERS; });
+            if (queue.empty())
+                break;
+            Message* message = queue.front();
+            queue.pop_front();
+            lock.unlock();
+
+            if (message->sequence != next[message->producer]++)
+                errors++;
+            pool.destroy(message);
+            pool.deallocate(message);
+
+            lock.lock();
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.push_back(std::thread([&, p] {
+            for (int i = 0; i < MESSAGES; i++) {
+                Message* message = pool.allocate();
+                pool.construct(message, Message{p, i});
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(message);
+                queueCond.notify_one();
+            }
+            std::lock_guard<std::mutex> lock(queueMutex);
+            finished++;
+            queueCond.notify_one();
+        }));
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers[p].join();
+    }
+    consumer.join();
+
+    ok &= errors == 0;
+    std::cout << "remote deallocate: " << errors << " errors\n";
+
+    // 生产者已经退出, 新线程会接管它们留下的堆
+    std::thread adopter([&] {
+        std::vector<Message*> messages;
+        for (int i = 0; i < MESSAGES; i++) {
+            messages.push_back(pool.allocate());
+            pool.construct(messages.back(), Message{0, i});
+        }
+        for (int i = 0; i < MESSAGES; i++) {
+            if (messages[i]->sequence != i)
+                errors++;
+            pool.deallocate(messages[i]);
+        }
+    });
+    adopter.join();
+
+    ok &= errors == 0;
+    std::cout << "orphan heaps: " << (errors == 0 ? "ok" : "FAILED") << "\n";
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
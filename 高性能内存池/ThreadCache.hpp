@@ -0,0 +1,118 @@
+#ifndef THREAD_CACHE_HPP
+#define THREAD_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 需要为每个线程保存私有缓存的对象 (例如内存池) 继承它
+class ThreadCacheOwner {
+public:
+    // 线程退出时对它保存的每份缓存调用一次, 调用期间 owner 不会被 detach
+    virtual void threadExit(void* cache) noexcept = 0;
+
+protected:
+    ~ThreadCacheOwner() = default;
+};
+
+// 线程私有缓存的登记表: 每个线程按 owner 的 id 保存一份缓存指针.
+// id 全局唯一且不会复用, 所以 owner 销毁之后线程里残留的旧记录不会被误用
+class ThreadCacheRegistry {
+public:
+    // 登记 owner, 返回它的 id
+    static uint64_t attach(ThreadCacheOwner* owner);
+    // owner 析构前调用, 返回之后不会再有 threadExit 回调; 各线程的缓存由 owner 自己释放
+    static void detach(uint64_t id);
+
+    // 当前线程为 id 保存的缓存, 没有时返回 nullptr
+    static void* get(uint64_t id) {
+        Local_& local = local_();
+        if (local.lastId == id)
+            return local.lastCache;
+        for (size_t i = 0; i < local.entries.size(); i++) {
+            if (local.entries[i].first == id) {
+                local.lastId = id;
+                local.lastCache = local.entries[i].second;
+                return local.lastCache;
+            }
+        }
+        return nullptr;
+    }
+    static void set(uint64_t id, void* cache);
+
+private:
+    struct Global_ {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, ThreadCacheOwner*> owners;
+        std::atomic<uint64_t> nextId{1};
+    };
+
+    struct Local_ {
+        // 最近一次访问的记录, 大多数线程只使用一两个 owner
+        uint64_t lastId = 0;
+        void* lastCache = nullptr;
+        std::vector<std::pair<uint64_t, void*>> entries;
+
+        ~Local_();
+    };
+
+    static Global_& global_() {
+        static Global_ global;
+        return global;
+    }
+    static Local_& local_() {
+        thread_local Local_ local;
+        return local;
+    }
+};
+
+inline uint64_t ThreadCacheRegistry::attach(ThreadCacheOwner* owner) {
+    Global_& global = global_();
+    uint64_t id = global.nextId++;
+    std::lock_guard<std::mutex> lock(global.mutex);
+    global.owners[id] = owner;
+    return id;
+}
+
+inline void ThreadCacheRegistry::detach(uint64_t id) {
+    Global_& global = global_();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    global.owners.erase(id);
+}
+
+inline void ThreadCacheRegistry::set(uint64_t id, void* cache) {
+    Local_& local = local_();
+
+    // 记录数翻倍时顺便清理已经销毁的 owner 留下的记录
+    if (!local.entries.empty() && (local.entries.size() & (local.entries.size() - 1)) == 0) {
+        Global_& global = global_();
+        std::lock_guard<std::mutex> lock(global.mutex);
+        size_t count = 0;
+        for (size_t i = 0; i < local.entries.size(); i++) {
+            if (global.owners.count(local.entries[i].first) != 0)
+                local.entries[count++] = local.entries[i];
+        }
+        local.entries.resize(count);
+    }
+
+    local.entries.push_back(std::make_pair(id, cache));
+    local.lastId = id;
+    local.lastCache = cache;
+}
+
+// 线程退出: 把缓存交还给仍然存活的 owner
+inline ThreadCacheRegistry::Local_::~Local_() {
+    Global_& global = global_();
+    std::lock_guard<std::mutex> lock(global.mutex);
+    for (size_t i = 0; i < entries.size(); i++) {
+        std::unordered_map<uint64_t, ThreadCacheOwner*>::iterator it = global.owners.find(entries[i].first);
+        if (it != global.owners.end())
+            it->second->threadExit(entries[i].second);
+    }
+}
+
+#endif // THREAD_CACHE_HPP
@@ -0,0 +1,165 @@
+#ifndef THREAD_CACHED_MEMORY_POOL_HPP
+#define THREAD_CACHED_MEMORY_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "MemoryPool.hpp"
+#include "ThreadCache.hpp"
+
+// 多线程共享的内存池: 每个线程有一个容量为 CacheSize 的对象槽缓存 (magazine),
+// allocate/deallocate 只访问本线程的缓存, 不加锁;
+// 缓存空了从中心内存池批量取 CacheSize / 2 个, 满了批量还回一半, 只有这时才加锁.
+// 一个线程释放的对象槽会经过中心内存池被其他线程复用, 线程退出时缓存全部还给中心内存池.
+// 这是对象池而不是标准库的分配器: 不能复制, 没有 rebind, 每次只分配一个对象
+template <typename T, size_t BlockSize = 4096, size_t CacheSize = 64>
+class ThreadCachedMemoryPool final : private ThreadCacheOwner {
+public:
+    ThreadCachedMemoryPool()
+        : id_(ThreadCacheRegistry::attach(this)) {
+    }
+    ~ThreadCachedMemoryPool() noexcept;
+
+    ThreadCachedMemoryPool(const ThreadCachedMemoryPool&) = delete;
+    ThreadCachedMemoryPool& operator=(const ThreadCachedMemoryPool&) = delete;
+
+    // 分配一个对象, n 不为 1 时抛出 std::bad_alloc; hint 会被忽略
+    T* allocate(size_t n = 1, const T* hint = 0);
+
+    // 调用构造函数
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    // 可以在任意线程释放, 不要求是分配它的线程; n 只能是 1
+    void deallocate(T* p, size_t n = 1);
+
+    template <typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+    // 把当前线程缓存的对象槽全部还给中心内存池
+    void flush();
+
+private:
+    // 每次与中心内存池交换的对象槽个数
+    static const size_t batchSize_ = CacheSize / 2;
+
+    struct Cache_ {
+        size_t count = 0;
+        T* slots[CacheSize];
+    };
+
+    uint64_t id_;
+    // 保护 central_ 和 caches_
+    std::mutex mutex_;
+    MemoryPool<T, BlockSize> central_;
+    // 所有线程的缓存, 在析构时统一释放
+    std::vector<Cache_*> caches_;
+
+    Cache_* localCache_();
+    void refill_(Cache_* cache);
+    void release_(Cache_* cache, size_t count);
+    void threadExit(void* cache) noexcept override;
+
+    static_assert(CacheSize >= 2, "CacheSize is too small.");
+};
+
+template <typename T, size_t BlockSize, size_t CacheSize>
+ThreadCachedMemoryPool<T, BlockSize, CacheSize>::~ThreadCachedMemoryPool() noexcept {
+    // 先注销, 之后退出的线程不会再访问这个内存池
+    ThreadCacheRegistry::detach(id_);
+    for (size_t i = 0; i < caches_.size(); i++) {
+        delete caches_[i];
+    }
+}
+
+template <typename T, size_t BlockSize, size_t CacheSize>
+T* ThreadCachedMemoryPool<T, BlockSize, CacheSize>::allocate(size_t n, const T* /*hint*/) {
+    if (n != 1)
+        throw std::bad_alloc();
+
+    Cache_* cache = localCache_();
+    if (cache->count == 0)
+        refill_(cache);
+    return cache->slots[--cache->count];
+}
+
+template <typename T, size_t BlockSize, size_t CacheSize>
+void ThreadCachedMemoryPool<T, BlockSize, CacheSize>::deallocate(T* p, size_t /*n*/) {
+    if (p == nullptr)
+        return;
+
+    Cache_* cache = localCache_();
+    if (cache->count == CacheSize)
+        release_(cache, batchSize_);
+    cache->slots[cache->count++] = p;
+}
+
+template <typename T, size_t BlockSize, size_t CacheSize>
+void ThreadCachedMemoryPool<T, BlockSize, CacheSize>::flush() {
+    Cache_* cache = static_cast<Cache_*>(ThreadCacheRegistry::get(id_));
+    if (cache != nullptr)
+        release_(cache, cache->count);
+}
+
+// 当前线程的缓存, 第一次使用时创建
+template <typename T, size_t BlockSize, size_t CacheSize>
+typename ThreadCachedMemoryPool<T, BlockSize, CacheSize>::Cache_* ThreadCachedMemoryPool<T, BlockSize, CacheSize>::localCache_() {
+    Cache_* cache = static_cast<Cache_*>(ThreadCacheRegistry::get(id_));
+    if (cache != nullptr)
+        return cache;
+
+    cache = new Cache_;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        caches_.push_back(cache);
+    }
+    ThreadCacheRegistry::set(id_, cache);
+    return cache;
+}
+
+// 从中心内存池取一批对象槽
+template <typename T, size_t BlockSize, size_t CacheSize>
+void ThreadCachedMemoryPool<T, BlockSize, CacheSize>::refill_(Cache_* cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (cache->count < batchSize_) {
+        cache->slots[cache->count++] = central_.allocate();
+    }
+}
+
+// 把缓存顶部的 count 个对象槽还给中心内存池
+template <typename T, size_t BlockSize, size_t CacheSize>
+void ThreadCachedMemoryPool<T, BlockSize, CacheSize>::release_(Cache_* cache, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (count-- > 0) {
+        central_.deallocate(cache->slots[--cache->count]);
+    }
+}
+
+// 线程退出: 缓存中的对象槽还给中心内存池, 释放缓存本身
+template <typename T, size_t BlockSize, size_t CacheSize>
+void ThreadCachedMemoryPool<T, BlockSize, CacheSize>::threadExit(void* ptr) noexcept {
+    Cache_* cache = static_cast<Cache_*>(ptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    while (cache->count > 0) {
+        central_.deallocate(cache->slots[--cache->count]);
+    }
+    for (size_t i = 0; i < caches_.size(); i++) {
+        if (caches_[i] == cache) {
+            caches_[i] = caches_.back();
+            caches_.pop_back();
+            break;
+        }
+    }
+    delete cache;
+}
+
+#endif // THREAD_CACHED_MEMORY_POOL_HPP
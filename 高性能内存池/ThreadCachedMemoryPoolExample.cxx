@@ -0,0 +1,83 @@
+// ThreadCachedMemoryPool 的示例: 多个线程共享一个内存池, 对象可以在其他线程释放
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "ThreadCachedMemoryPool.hpp" // ThreadCachedMemoryPool<T>
+
+// 线程个数
+#define THREADS 4
+// 每个线程分配的对象个数
+#define ELEMS 100000
+
+struct Item {
+    int owner;
+    int value;
+};
+
+int main() {
+    bool ok = true;
+
+    // 每次只能分配一个对象, 要求连续的多个对象时抛出 std::bad_alloc
+    ThreadCachedMemoryPool<Item> pool;
+    try {
+        pool.allocate(2);
+        ok = false;
+    } catch (const std::bad_alloc&) {
+    }
+    std::cout << "allocate(2): " << (ok ? "rejected" : "FAILED") << "\n";
+
+    // 每个线程分配一批对象, 留下一半交给下一个线程释放, 其余自己释放
+    std::vector<Item*> handoff[THREADS];
+    std::mutex handoffMutex[THREADS];
+    std::vector<int> errors(THREADS, 0);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; t++) {
+        threads.push_back(std::thread([&, t] {
+            std::vector<Item*> items;
+            for (int i = 0; i < ELEMS; i++) {
+                Item* item = pool.allocate();
+                pool.construct(item, Item{t, i});
+                items.push_back(item);
+            }
+            for (int i = 0; i < ELEMS; i++) {
+                if (items[i]->owner != t || items[i]->value != i)
+                    errors[t]++;
+                if (i % 2 == 0) {
+                    std::lock_guard<std::mutex> lock(handoffMutex[(t + 1) % THREADS]);
+                    handoff[(t + 1) % THREADS].push_back(items[i]);
+                } else {
+                    pool.deallocate(items[i]);
+                }
+            }
+
+            // 释放上一个线程交过来的对象 (可能还没有全部交过来, 剩下的由主线程释放)
+            std::lock_guard<std::mutex> lock(handoffMutex[t]);
+            for (size_t i = 0; i < handoff[t].size(); i++) {
+                if (handoff[t][i]->owner != (t + THREADS - 1) % THREADS)
+                    errors[t]++;
+                pool.deallocate(handoff[t][i]);
+            }
+            handoff[t].clear();
+        }));
+    }
+    for (int t = 0; t < THREADS; t++) {
+        threads[t].join();
+    }
+
+    int total = 0;
+    for (int t = 0; t < THREADS; t++) {
+        for (size_t i = 0; i < handoff[t].size(); i++) {
+            pool.deallocate(handoff[t][i]);
+        }
+        total += errors[t];
+    }
+    ok &= total == 0;
+    std::cout << "cross-thread deallocate: " << total << " errors\n";
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}